@@ -58,6 +58,8 @@
 
 #include "SimpleCompressor.h"
 #include "CompressorEditor.h"
+#include "HibernationController.h"
+#include "FixedBlockBuffer.h"
 
 //==============================================================================
 /** A simple compressor that applies dynamic range compression to audio.
@@ -80,6 +82,24 @@ public:
     {
         // Add a sub-tree to store the state of our UI
         state.state.addChild ({ "uiState", { { "width",  700 }, { "height", 700 } }, {} }, -1, nullptr);
+
+        // Feed the QC statistics from the audio thread
+        compressor.setStatistics (&statistics);
+
+        // Record safety fallbacks from the audio thread without blocking it
+        compressor.setLogRing (&logRing);
+        logWriter->addRing (&logRing);
+        logWriter->addRing (&fallbackLogRing);
+
+        // Release the log storage after a long stretch of silence
+        hibernationWorker->addController (&hibernation);
+    }
+
+    ~JuceDemoPluginAudioProcessor() override
+    {
+        hibernationWorker->removeController (&hibernation);
+        logWriter->removeRing (&fallbackLogRing);
+        logWriter->removeRing (&logRing);
     }
 
     //==============================================================================
@@ -104,6 +124,24 @@ public:
     {
         // Initialize the compressor with the new sample rate
         compressor.prepareToPlay(newSampleRate);
+
+        // Start a new QC programme
+        statistics.setSampleRate (newSampleRate);
+        statistics.reset();
+
+        hibernation.prepare (newSampleRate);
+
+        // Optionally re-block the host's buffers, reporting the FIFO delay as latency
+        internalBlockSize = jmax (0, static_cast<int> (state.state.getProperty ("internalBlockSize", 0)));
+        auto numChannels = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+        if (internalBlockSize > 0)
+        {
+            fixedBlocksFloat.prepare (numChannels, internalBlockSize);
+            fixedBlocksDouble.prepare (numChannels, internalBlockSize);
+        }
+
+        setLatencySamples (internalBlockSize);
     }
 
     void releaseResources() override
@@ -116,6 +154,8 @@ public:
     {
         // Reset the compressor state
         compressor.reset();
+        fixedBlocksFloat.reset();
+        fixedBlocksDouble.reset();
     }
 
     bool supportsDoublePrecisionProcessing() const override { return true; }
@@ -124,12 +164,14 @@ public:
     void processBlock (AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override
     {
         jassert (! isUsingDoublePrecision());
+        ScopedNoDenormals noDenormals;
         process (buffer, midiMessages);
     }
 
     void processBlock (AudioBuffer<double>& buffer, MidiBuffer& midiMessages) override
     {
         jassert (isUsingDoublePrecision());
+        ScopedNoDenormals noDenormals;
         process (buffer, midiMessages);
     }
 
@@ -138,7 +180,7 @@ public:
 
     AudioProcessorEditor* createEditor() override
     {
-        return new JuceDemoPluginAudioProcessorEditor (*this, state);
+        return new JuceDemoPluginAudioProcessorEditor (*this, state, &statistics);
     }
 
     //==============================================================================
@@ -179,6 +221,17 @@ public:
     float getCurrentThreshold() const { return compressor.getThreshold(); }
     float getCurrentRatio() const { return compressor.getRatio(); }
 
+    // Programme-level QC statistics, safe to read from any thread
+    const DynamicsStatistics& getStatistics() const { return statistics; }
+
+    // Process in fixed blocks of this many samples (0 = follow the host), at the cost of
+    // the same amount of latency. Saved with the state; takes effect at the next prepareToPlay.
+    void setInternalBlockSize (int numSamples)  { state.state.setProperty ("internalBlockSize", jmax (0, numSamples), nullptr); }
+    int getInternalBlockSize() const            { return internalBlockSize; }
+
+    // How much silence puts this instance to sleep. Call while not playing.
+    void setHibernationOptions (const HibernationController::Options& options) { hibernation.setOptions (options); }
+
 private:
     //==============================================================================
     /** This is the editor component that our filter will display. */
@@ -194,11 +247,50 @@ private:
         for (auto i = getTotalNumInputChannels(); i < getTotalNumOutputChannels(); ++i)
             buffer.clear (i, 0, buffer.getNumSamples());
 
+        if (internalBlockSize > 0)
+            getFixedBlocks<FloatType>().process (buffer, [this] (AudioBuffer<FloatType>& block) { processCompressorBlock (block); });
+        else
+            processCompressorBlock (buffer);
+    }
+
+    template <typename FloatType>
+    void processCompressorBlock (AudioBuffer<FloatType>& buffer)
+    {
         // Update compressor parameters if they've changed
         updateCompressorParameters();
 
+        // After a long silence, skip the compressor until the input comes back.
+        // Only then does the block need a peak scan of its own. Non-finite input
+        // scans as an infinite peak, so it wakes the compressor and gets sanitized.
+        if (hibernation.isAsleep())
+        {
+            auto peak = SimpleCompressor::getFinitePeak (buffer);
+
+            if (hibernation.processBlock (peak, compressor.isSettled(), buffer.getNumSamples()))
+            {
+                compressor.processHibernatedBuffer (buffer);
+                return;
+            }
+        }
+
+        // Waking up: log to the small fallback ring until the main one is back
+        compressor.setLogRing (hibernation.isAwake() ? &logRing : &fallbackLogRing);
+
         // Process the buffer through the compressor
         compressor.processBuffer(buffer);
+
+        // Awake, the detector has already measured the block's peak
+        if (! hibernation.isAsleep())
+            hibernation.processBlock (compressor.getLastInputPeak(), compressor.isSettled(), buffer.getNumSamples());
+    }
+
+    template <typename FloatType>
+    FixedBlockBuffer<FloatType>& getFixedBlocks()
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return fixedBlocksDouble;
+        else
+            return fixedBlocksFloat;
     }
 
     void updateCompressorParameters()
@@ -210,11 +302,9 @@ private:
         auto releaseNorm = state.getParameter ("release")->getValue();
         auto makeupNorm = state.getParameter ("makeup")->getValue();
         
-        // Convert ratio from preset index (0-7) to actual ratio value
-        static const float ratioPresets[] = { 1.0f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 10.0f, 20.0f };
+        // Convert ratio to a preset index (0-7), which selects the compressor's ratio kernel
         auto ratioIndex = static_cast<int>(ratioNorm * 7.0f + 0.5f);
-        ratioIndex = jlimit(0, 7, ratioIndex);
-        auto actualRatio = ratioPresets[ratioIndex];
+        ratioIndex = jlimit(0, SimpleCompressor::numRatioPresets - 1, ratioIndex);
         
         // Convert normalized values to actual ranges
         auto threshold = -60.0f + thresholdNorm * 60.0f;  // -60dB to 0dB
@@ -223,12 +313,30 @@ private:
         auto makeupGain = -30.0f + makeupNorm * 60.0f;    // -30dB to +30dB
         
         // Update the simple compressor with actual values
-        compressor.setParameters(threshold, actualRatio, attack, release, makeupGain);
+        compressor.setParametersWithRatioPreset(threshold, ratioIndex, attack, release, makeupGain);
     }
 
     // The simple compressor instance
     SimpleCompressor compressor;
 
+    // Fixed internal block mode, for hosts with tiny or irregular buffers
+    int internalBlockSize = 0;
+    FixedBlockBuffer<float> fixedBlocksFloat;
+    FixedBlockBuffer<double> fixedBlocksDouble;
+
+    // QC statistics gathered by the compressor
+    DynamicsStatistics statistics;
+
+    // Wait-free log of DSP safety fallbacks, written to disk by a shared background thread
+    RealtimeLogRing logRing { "AudioPluginDemo@" + String::toHexString ((pointer_sized_int) this) };
+    RealtimeLogRing fallbackLogRing { "AudioPluginDemo@" + String::toHexString ((pointer_sized_int) this) + " (waking)", 32 };
+    SharedResourcePointer<RealtimeLogWriter> logWriter;
+
+    // Idle detection; the shared worker frees and re-allocates logRing's storage
+    HibernationController hibernation { [this] { return logRing.releaseStorage(); },
+                                        [this] { return logRing.reserveStorage(); } };
+    SharedResourcePointer<HibernationWorker> hibernationWorker;
+
     static BusesProperties getBusesProperties()
     {
         return BusesProperties().withInput  ("Input",  AudioChannelSet::stereo(), true)
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "OfflineRenderer.h"
+#include "NumaTopology.h"
+#include "StreamingRenderPipeline.h"
+
+//==============================================================================
+/** Renders many files in parallel, keeping each worker and its memory on one NUMA node.
+
+    Jobs are split between the nodes up front, in proportion to each node's worker
+    count. Every worker pins itself to its node's CPUs before it allocates anything,
+    so its I/O buffer (a NodeLocalBuffer, optionally on huge pages), its renderer and
+    the codec state it creates all land in node-local memory. A worker whose node has
+    run out of jobs takes work from another node. That is still safe, because the job
+    only brings file names with it and all of its memory is allocated by the thief.
+
+    Jobs that read or write a compressed format go through a StreamingRenderPipeline,
+    with decoding and encoding on a codec thread pool. Each node has its own pool,
+    pinned to the node's CPUs, so the codec state stays next to the blocks it fills.
+    The codec threads come out of the node's CPU budget: by default half the node's
+    CPUs decode and encode and the rest run workers, so the batch never runs more
+    threads than there are CPUs.
+*/
+class BatchRenderer
+{
+public:
+    //==============================================================================
+    struct Job
+    {
+        File input;
+        File output;
+        OfflineRenderer::Settings settings;
+    };
+
+    struct Options
+    {
+        bool pinWorkersToNodes = true;
+        bool useHugePages = false;
+        int workersPerNode = 0;                         // 0 = the node's CPUs less its codec threads
+        int maxChannels = DynamicsStatistics::maxChannels;
+        int maxBlockSize = 4096;                        // largest Settings::blockSize of any job
+        bool streamCompressedFormats = true;            // overlap codec and DSP for FLAC etc.
+        int codecThreadsPerNode = 0;                    // 0 = half the node's CPUs, if any job streams
+    };
+
+    //==============================================================================
+    explicit BatchRenderer(const Options& optionsToUse)
+        : options(optionsToUse), topology(NumaTopology::detect())
+    {
+    }
+
+    const NumaTopology& getTopology() const { return topology; }
+
+    /** Render all jobs and return one result per job, in job order */
+    Array<Result> render(const Array<Job>& jobs)
+    {
+        auto numNodes = topology.getNumNodes();
+        std::vector<NodeQueue> queues((size_t) numNodes);
+        std::vector<Result> results((size_t) jobs.size(), Result::ok());
+
+        auto anyJobStreams = std::any_of(jobs.begin(), jobs.end(), [this](const Job& job) { return shouldStream(job); });
+
+        // Codec and worker threads per node, and jobs shared out in proportion to the workers
+        std::vector<int> codecThreadsOnNode((size_t) numNodes), workersOnNode((size_t) numNodes);
+
+        for (int node = 0; node < numNodes; ++node)
+        {
+            auto cpusOnNode = topology.getNodes().getReference(node).cpus.size();
+
+            if (anyJobStreams)
+                codecThreadsOnNode[(size_t) node] = jmax(1, options.codecThreadsPerNode > 0 ? options.codecThreadsPerNode
+                                                                                            : cpusOnNode / 2);
+
+            workersOnNode[(size_t) node] = jmax(1, options.workersPerNode > 0 ? options.workersPerNode
+                                                                              : cpusOnNode - codecThreadsOnNode[(size_t) node]);
+        }
+
+        for (int jobIndex = 0; jobIndex < jobs.size(); ++jobIndex)
+        {
+            auto leastLoaded = 0;
+
+            for (int node = 1; node < numNodes; ++node)
+                if (queues[(size_t) node].jobs.size() * (size_t) workersOnNode[(size_t) leastLoaded]
+                     < queues[(size_t) leastLoaded].jobs.size() * (size_t) workersOnNode[(size_t) node])
+                    leastLoaded = node;
+
+            queues[(size_t) leastLoaded].jobs.push_back(jobIndex);
+        }
+
+        // Decoders and encoders from the workers of a node share that node's threads
+        OwnedArray<ThreadPool> codecPools;
+
+        for (int node = 0; node < numNodes; ++node)
+        {
+            auto numThreads = codecThreadsOnNode[(size_t) node];
+            auto* pool = codecPools.add(numThreads > 0 ? new ThreadPool(numThreads) : nullptr);
+
+            if (pool != nullptr && options.pinWorkersToNodes)
+                pinPoolThreads(*pool, numThreads, topology.getNodes().getReference(node));
+        }
+
+        OwnedArray<Worker> workers;
+
+        for (int node = 0; node < numNodes; ++node)
+            for (int i = 0; i < workersOnNode[(size_t) node]; ++i)
+                workers.add(new Worker(*this, node, jobs, queues, results, codecPools[node]));
+
+        for (auto* worker : workers)
+            worker->startThread();
+
+        for (auto* worker : workers)
+            worker->waitForThreadToExit(-1);
+
+        Array<Result> resultArray;
+
+        for (auto& result : results)
+            resultArray.add(result);
+
+        return resultArray;
+    }
+
+private:
+    //==============================================================================
+    struct NodeQueue
+    {
+        std::vector<int> jobs;
+        std::atomic<size_t> next { 0 };
+
+        NodeQueue() = default;
+        NodeQueue(NodeQueue&& other) noexcept : jobs(std::move(other.jobs)), next(other.next.load()) {}
+    };
+
+    bool shouldStream(const Job& job) const
+    {
+        return options.streamCompressedFormats
+                && (StreamingRenderPipeline::isCompressedFormat(job.input)
+                     || StreamingRenderPipeline::isCompressedFormat(job.output));
+    }
+
+    /** Pin every thread of a pool to a node. Each thread gets one job that pins
+        it and then holds it until all the others are pinned, so no thread can
+        take two of the jobs and leave another unpinned.
+    */
+    static void pinPoolThreads(ThreadPool& pool, int numThreads, const NumaTopology::Node& node)
+    {
+        struct Barrier
+        {
+            std::atomic<int> remaining { 0 };
+            WaitableEvent allPinned { true };
+        };
+
+        auto barrier = std::make_shared<Barrier>();
+        barrier->remaining = numThreads;
+
+        for (int i = 0; i < numThreads; ++i)
+        {
+            pool.addJob([barrier, node]
+            {
+                NumaTopology::pinCurrentThreadToNode(node);
+
+                if (--barrier->remaining == 0)
+                    barrier->allPinned.signal();
+                else
+                    barrier->allPinned.wait(-1);
+            });
+        }
+
+        barrier->allPinned.wait(-1);
+    }
+
+    class Worker : public Thread
+    {
+    public:
+        Worker(BatchRenderer& ownerToUse, int nodeIndexToUse, const Array<Job>& jobsToRender,
+               std::vector<NodeQueue>& queuesToUse, std::vector<Result>& resultsToFill, ThreadPool* codecPoolToUse)
+            : Thread("Batch render worker"),
+              owner(ownerToUse), nodeIndex(nodeIndexToUse),
+              jobs(jobsToRender), queues(queuesToUse), results(resultsToFill), codecPool(codecPoolToUse)
+        {
+        }
+
+        void run() override
+        {
+            auto& node = owner.topology.getNodes().getReference(nodeIndex);
+
+            // Pin first, so every allocation below is made on this node
+            if (owner.options.pinWorkersToNodes)
+                NumaTopology::pinCurrentThreadToNode(node);
+
+            auto numChannels = jmax(1, owner.options.maxChannels);
+            auto numSamples = jmax(1, owner.options.maxBlockSize);
+
+            NodeLocalBuffer memory(sizeof(float) * (size_t) numChannels * (size_t) numSamples,
+                                   node.id, owner.options.useHugePages);
+
+            HeapBlock<float*> channelPointers((size_t) numChannels);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                channelPointers[channel] = static_cast<float*>(memory.getData()) + (size_t) channel * (size_t) numSamples;
+
+            AudioBuffer<float> workBuffer(channelPointers.get(), numChannels, numSamples);
+            OfflineRenderer renderer;
+            std::unique_ptr<StreamingRenderPipeline> pipeline;
+
+            if (codecPool != nullptr)
+                pipeline = std::make_unique<StreamingRenderPipeline>(renderer, *codecPool);
+
+            for (int jobIndex = takeJob(); jobIndex >= 0 && ! threadShouldExit(); jobIndex = takeJob())
+            {
+                auto& job = jobs.getReference(jobIndex);
+
+                if (pipeline != nullptr && owner.shouldStream(job))
+                    results[(size_t) jobIndex] = pipeline->renderFile(job.input, job.output, job.settings);
+                else
+                    results[(size_t) jobIndex] = renderer.renderFile(job.input, job.output, job.settings, workBuffer);
+            }
+        }
+
+    private:
+        /** Next job from this worker's own node, then from the others in order */
+        int takeJob()
+        {
+            auto numNodes = (int) queues.size();
+
+            for (int offset = 0; offset < numNodes; ++offset)
+            {
+                auto& queue = queues[(size_t) ((nodeIndex + offset) % numNodes)];
+                auto index = queue.next.fetch_add(1);
+
+                if (index < queue.jobs.size())
+                    return queue.jobs[index];
+            }
+
+            return -1;
+        }
+
+        BatchRenderer& owner;
+        int nodeIndex;
+        const Array<Job>& jobs;
+        std::vector<NodeQueue>& queues;
+        std::vector<Result>& results;
+        ThreadPool* codecPool;      // this node's, or nullptr if no job streams
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+    };
+
+    //==============================================================================
+    Options options;
+    NumaTopology topology;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
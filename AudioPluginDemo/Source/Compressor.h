@@ -4,6 +4,8 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include "RealtimeLogger.h"
 
 //==============================================================================
 /** A standalone compressor DSP class that can be used independently of the GUI.
@@ -44,134 +46,14 @@ public:
     {
         envelope = 0.0f;
         lastGain = 1.0f;  // Reset gain smoothing state
+        blockStartPosition = 0;
+        activeLogPaths.fill(0);
     }
     
     /** Process a single sample through the compressor */
     float processSample(float input)
     {
-        // Safety check for invalid input
-        if (!std::isfinite(input))
-            return 0.0f;
-        
-        // Calculate input level in dB with safety limits
-        auto absInput = std::abs(input);
-        absInput = std::max(absInput, 1e-10f);  // Prevent log of zero
-        auto inputLevel = 20.0f * log10f(absInput);
-        
-        // Clamp input level to reasonable range to prevent extreme calculations
-        inputLevel = jlimit(-120.0f, 20.0f, inputLevel);
-        
-        // Calculate gain reduction
-        auto gainReduction = 0.0f;
-        if (inputLevel > threshold)
-        {
-            auto overThreshold = inputLevel - threshold;
-            
-            if (overThreshold > 0.0f) {
-                // Protect against division by very small ratio values
-                auto safeRatio = std::max(ratio, 1.0f);
-                gainReduction = overThreshold - (overThreshold / safeRatio);
-                
-                // Limit maximum gain reduction to prevent extreme compression
-                gainReduction = std::min(gainReduction, 60.0f);
-            }
-        }
-        
-        // Apply attack/release envelope with improved stability
-        auto targetGainReduction = gainReduction;
-        
-        // IMPROVED: Add envelope stabilization for extreme settings
-        auto envelopeDiff = targetGainReduction - envelope;
-        auto absEnvelopeDiff = std::abs(envelopeDiff);
-        
-        // Detect potential oscillation and dampen it
-        bool isExtremeSettings = (attack < 2.0f && release < 10.0f);
-        
-        // FIXED: Add dead zone for idle envelope behavior (fixes threshold > -24dB noise)
-        // When target is very close to zero and current envelope is also close to zero,
-        // force both to exactly zero to prevent micro-oscillations
-        if (targetGainReduction < 0.1f && envelope < 0.1f) {
-            envelope = 0.0f; // Force to exact zero - no hunting around zero
-        }
-        // Also handle the case where we're very close to the target
-        else if (absEnvelopeDiff < 0.01f) {
-            envelope = targetGainReduction; // Snap to target if very close
-        }
-        else if (targetGainReduction > envelope)
-        {
-            // Attack phase - improved stability for fast attacks
-            if (isExtremeSettings) {
-                // For extreme settings, use more conservative coefficients
-                auto stabilizedCoeff = attackCoeff * 0.5f; // More aggressive dampening
-                envelope += stabilizedCoeff * envelopeDiff;
-            } else if (attack < 2.0f) {
-                // Use a smoother curve for very fast attacks
-                auto smoothedCoeff = attackCoeff * 0.8f;
-                envelope += smoothedCoeff * envelopeDiff;
-            } else {
-                // Normal attack behavior
-                envelope += attackCoeff * envelopeDiff;
-            }
-        }
-        else
-        {
-            // Release phase - improved stability for fast releases
-            if (isExtremeSettings) {
-                // For extreme settings, use more conservative release
-                auto stabilizedCoeff = releaseCoeff * 0.7f; // More conservative
-                envelope += stabilizedCoeff * envelopeDiff;
-            } else {
-                // Normal release behavior
-                envelope += releaseCoeff * envelopeDiff;
-            }
-        }
-        
-        // Enhanced bounds check with hysteresis to prevent rapid oscillation
-        envelope = jlimit(0.0f, 60.0f, envelope);
-        
-        // Apply compression and makeup gain with safety limits
-        auto gainInDb = -envelope + makeupGain;
-        
-        // Limit total gain to prevent extreme amplification
-        gainInDb = jlimit(-60.0f, 20.0f, gainInDb);
-        
-        auto compressedGain = powf(10.0f, gainInDb / 20.0f);
-        
-        // Final safety check on gain value
-        if (!std::isfinite(compressedGain))
-            compressedGain = 1.0f;
-        
-        // Limit gain to reasonable range
-        compressedGain = jlimit(0.001f, 10.0f, compressedGain);
-        
-        // Very subtle gain smoothing to prevent pops
-        // FIXED: Use member variable instead of static to prevent inter-channel issues
-        auto gainDiff = compressedGain - lastGain;
-        
-        // Apply minimal smoothing only for extremely fast attacks
-        if (attack < 1.0f) {
-            // Very gentle smoothing for ultra-fast attacks
-            auto smoothingFactor = std::max(0.05f, attack / 100.0f);
-            compressedGain = lastGain + smoothingFactor * gainDiff;
-        }
-        
-        lastGain = compressedGain;
-        
-        auto output = input * compressedGain;
-        
-        // Final output safety check
-        if (!std::isfinite(output))
-            return 0.0f;
-            
-        // Add harmonic saturation based on compression intensity
-        // This creates that classic analog compressor distortion when pushed hard
-        auto saturationOutput = addHarmonicSaturation(output, envelope);
-        
-        // Add extreme saturation for crazy settings (fast attack/release + high ratio)
-        auto extremeOutput = addExtremeSaturation(saturationOutput, envelope, attack, release, ratio);
-        
-        // Final soft limiting to prevent harsh clipping
-        return softLimit(extremeOutput);
+        return processSampleAt(input, blockStartPosition++);
     }
     
     /** Process a buffer of samples */
@@ -184,14 +66,23 @@ public:
         for (auto channel = 0; channel < numChannels; ++channel)
         {
             auto channelData = buffer.getWritePointer(channel);
+            currentChannel = channel;
             
             for (auto sample = 0; sample < numSamples; ++sample)
             {
-                channelData[sample] = processSample(static_cast<float>(channelData[sample]));
+                channelData[sample] = processSampleAt(static_cast<float>(channelData[sample]),
+                                                      blockStartPosition + sample);
             }
         }
+        
+        blockStartPosition += numSamples;
     }
     
+    /** Attach a realtime log ring for the safety fallbacks and extreme-settings paths.
+        Pass nullptr to detach. The ring must outlive the compressor.
+    */
+    void setLogRing(RealtimeLogRing* newLogRing) { logRing = newLogRing; }
+    
     //==============================================================================
     /** Set compressor parameters and update coefficients */
     void setParameters(float newThreshold, float newRatio, float newAttack, 
@@ -418,6 +309,176 @@ public:
     }
     
 private:
+    //==============================================================================
+    /** The signal path, with position the sample's position in the stream for logging */
+    float processSampleAt(float input, int64 position)
+    {
+        // Safety check for invalid input
+        if (!std::isfinite(input))
+        {
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteInput, currentChannel, position, envelope);
+            return 0.0f;
+        }
+        
+        // Calculate input level in dB with safety limits
+        auto absInput = std::abs(input);
+        absInput = std::max(absInput, 1e-10f);  // Prevent log of zero
+        auto inputLevel = 20.0f * log10f(absInput);
+        
+        // Clamp input level to reasonable range to prevent extreme calculations
+        inputLevel = jlimit(-120.0f, 20.0f, inputLevel);
+        
+        // Calculate gain reduction
+        auto gainReduction = 0.0f;
+        if (inputLevel > threshold)
+        {
+            auto overThreshold = inputLevel - threshold;
+            
+            if (overThreshold > 0.0f) {
+                // Protect against division by very small ratio values
+                auto safeRatio = std::max(ratio, 1.0f);
+                gainReduction = overThreshold - (overThreshold / safeRatio);
+                
+                // Limit maximum gain reduction to prevent extreme compression
+                gainReduction = std::min(gainReduction, 60.0f);
+            }
+        }
+        
+        // Apply attack/release envelope with improved stability
+        auto targetGainReduction = gainReduction;
+        
+        // IMPROVED: Add envelope stabilization for extreme settings
+        auto envelopeDiff = targetGainReduction - envelope;
+        auto absEnvelopeDiff = std::abs(envelopeDiff);
+        
+        // Detect potential oscillation and dampen it
+        bool isExtremeSettings = (attack < 2.0f && release < 10.0f);
+        bool usedExtremeAttack = false, usedExtremeRelease = false, usedFastAttack = false;
+        
+        // FIXED: Add dead zone for idle envelope behavior (fixes threshold > -24dB noise)
+        // When target is very close to zero and current envelope is also close to zero,
+        // force both to exactly zero to prevent micro-oscillations
+        if (targetGainReduction < 0.1f && envelope < 0.1f) {
+            envelope = 0.0f; // Force to exact zero - no hunting around zero
+        }
+        // Also handle the case where we're very close to the target
+        else if (absEnvelopeDiff < 0.01f) {
+            envelope = targetGainReduction; // Snap to target if very close
+        }
+        else if (targetGainReduction > envelope)
+        {
+            // Attack phase - improved stability for fast attacks
+            if (isExtremeSettings) {
+                // For extreme settings, use more conservative coefficients
+                auto stabilizedCoeff = attackCoeff * 0.5f; // More aggressive dampening
+                envelope += stabilizedCoeff * envelopeDiff;
+                usedExtremeAttack = true;
+            } else if (attack < 2.0f) {
+                // Use a smoother curve for very fast attacks
+                auto smoothedCoeff = attackCoeff * 0.8f;
+                envelope += smoothedCoeff * envelopeDiff;
+                usedFastAttack = true;
+            } else {
+                // Normal attack behavior
+                envelope += attackCoeff * envelopeDiff;
+            }
+        }
+        else
+        {
+            // Release phase - improved stability for fast releases
+            if (isExtremeSettings) {
+                // For extreme settings, use more conservative release
+                auto stabilizedCoeff = releaseCoeff * 0.7f; // More conservative
+                envelope += stabilizedCoeff * envelopeDiff;
+                usedExtremeRelease = true;
+            } else {
+                // Normal release behavior
+                envelope += releaseCoeff * envelopeDiff;
+            }
+        }
+        
+        // Log the extreme-settings paths when they start being taken
+        logPathOnset<RealtimeLogEvent::extremeAttack>(usedExtremeAttack, position, envelope, targetGainReduction);
+        logPathOnset<RealtimeLogEvent::extremeRelease>(usedExtremeRelease, position, envelope, targetGainReduction);
+        logPathOnset<RealtimeLogEvent::fastAttackSmoothing>(usedFastAttack, position, envelope, targetGainReduction);
+        
+        // Enhanced bounds check with hysteresis to prevent rapid oscillation
+        envelope = jlimit(0.0f, 60.0f, envelope);
+        
+        // Apply compression and makeup gain with safety limits
+        auto gainInDb = -envelope + makeupGain;
+        
+        // Limit total gain to prevent extreme amplification
+        gainInDb = jlimit(-60.0f, 20.0f, gainInDb);
+        
+        auto compressedGain = powf(10.0f, gainInDb / 20.0f);
+        
+        // Final safety check on gain value
+        if (!std::isfinite(compressedGain))
+        {
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteGain, currentChannel, position, gainInDb, envelope);
+            compressedGain = 1.0f;
+        }
+        
+        // Limit gain to reasonable range
+        compressedGain = jlimit(0.001f, 10.0f, compressedGain);
+        
+        // Very subtle gain smoothing to prevent pops
+        // FIXED: Use member variable instead of static to prevent inter-channel issues
+        auto gainDiff = compressedGain - lastGain;
+        
+        // Apply minimal smoothing only for extremely fast attacks
+        if (attack < 1.0f) {
+            // Very gentle smoothing for ultra-fast attacks
+            auto smoothingFactor = std::max(0.05f, attack / 100.0f);
+            compressedGain = lastGain + smoothingFactor * gainDiff;
+        }
+        
+        lastGain = compressedGain;
+        
+        auto output = input * compressedGain;
+        
+        // Final output safety check
+        if (!std::isfinite(output))
+        {
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteOutput, currentChannel, position, input, compressedGain);
+            return 0.0f;
+        }
+            
+        // Add harmonic saturation based on compression intensity
+        // This creates that classic analog compressor distortion when pushed hard
+        auto saturationOutput = addHarmonicSaturation(output, envelope);
+        
+        // Add extreme saturation for crazy settings (fast attack/release + high ratio)
+        auto extremeOutput = addExtremeSaturation(saturationOutput, envelope, attack, release, ratio);
+        logPathOnset<RealtimeLogEvent::extremeSaturation>(attack <= 2.0f && release < 10.0f && ratio > 8.0f,
+                                                          position, envelope, ratio);
+        
+        // Final soft limiting to prevent harsh clipping
+        return softLimit(extremeOutput);
+    }
+    
+    /** Log a path once when it starts being taken, not on every sample it stays active */
+    template <RealtimeLogEvent event>
+    void logPathOnset(bool isActive, int64 position, float value0, float value1)
+    {
+        if constexpr (isRealtimeLogEventEnabled(event))
+        {
+            auto bit = 1u << static_cast<uint32>(event);
+            
+            auto& channelPaths = activeLogPaths[(size_t) jmin(currentChannel, maxLogChannels - 1)];
+            
+            if (isActive && (channelPaths & bit) == 0)
+                COMPRESSOR_RT_LOG(logRing, event, currentChannel, position, value0, value1);
+            
+            channelPaths = isActive ? (channelPaths | bit) : (channelPaths & ~bit);
+        }
+        else
+        {
+            ignoreUnused(isActive, position, value0, value1);
+        }
+    }
+    
     //==============================================================================
     // Compressor parameters
     float threshold = -20.0f;      // dB
@@ -435,6 +496,16 @@ private:
     double sampleRate = 44100.0;  // sample rate
     float lastGain = 1.0f;        // for gain smoothing (moved from static)
     
+    // Realtime logging
+    RealtimeLogRing* logRing = nullptr;
+    int currentChannel = 0;
+    int64 blockStartPosition = 0;
+    
+    // Paths active per channel, so a path on one channel doesn't hide its onset on
+    // another. Channels past the last share its mask.
+    static constexpr int maxLogChannels = 8;
+    std::array<uint32, maxLogChannels> activeLogPaths {};
+    
     // Metering variables
     mutable float inputLevel = -60.0f;
     mutable float outputLevel = -60.0f;
@@ -4,6 +4,7 @@
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 #include "BuildVersion.h"
+#include "DynamicsStatistics.h"
 
 //==============================================================================
 /** Custom Look and Feel for glowing labels */
@@ -67,6 +68,7 @@ public:
     LevelMeter(const String& labelText = "METER")
         : label(labelText)
     {
+        setName(labelText);
         addAndMakeVisible(label);
         addAndMakeVisible(valueLabel);
         
@@ -183,9 +185,11 @@ private:
 class CompressorEditor : public AudioProcessorEditor, private Value::Listener, private Timer
 {
 public:
-    CompressorEditor(AudioProcessor& processor, AudioProcessorValueTreeState& processorState)
+    CompressorEditor(AudioProcessor& processor, AudioProcessorValueTreeState& processorState,
+                     DynamicsStatistics* statisticsToShow = nullptr)
         : AudioProcessorEditor(processor),
           processorState(processorState),
+          statistics(statisticsToShow),
           thresholdAttachment(processorState, "threshold", thresholdSlider),
           attackAttachment(processorState, "attack", attackSlider),
           releaseAttachment(processorState, "release", releaseSlider),
@@ -202,6 +206,7 @@ public:
         // Add visual elements
         addAndMakeVisible(titleLabel);
         addAndMakeVisible(buildVersionLabel);
+        addAndMakeVisible(qcLabel);
         addAndMakeVisible(compressionMeter);
         addAndMakeVisible(inputMeter);
         addAndMakeVisible(outputMeter);
@@ -223,6 +228,14 @@ public:
         buildVersionLabel.setColour(Label::textColourId, Colours::lightgrey.withAlpha(0.7f));
         buildVersionLabel.setColour(Label::backgroundColourId, Colours::transparentBlack);
         buildVersionLabel.setTooltip(BuildVersion::getDetailedString());
+        
+        // Style the QC statistics readout
+        qcLabel.setName("QC");
+        qcLabel.setFont(FontOptions(12.0f, Font::plain));
+        qcLabel.setJustificationType(Justification::centredLeft);
+        qcLabel.setColour(Label::textColourId, Colours::lightgrey.withAlpha(0.7f));
+        qcLabel.setColour(Label::backgroundColourId, Colours::transparentBlack);
+        qcLabel.setVisible(statistics != nullptr);
 
         // Set resize limits for this plug-in
         setResizeLimits(700, 700, 1200, 1000);
@@ -303,6 +316,7 @@ public:
 
         // Build version in top-right corner
         auto versionBounds = bounds.removeFromTop(25);
+        qcLabel.setBounds(versionBounds.removeFromLeft(versionBounds.getWidth() * 2 / 3));
         buildVersionLabel.setBounds(versionBounds);
 
         // Title at the top
@@ -362,6 +376,8 @@ public:
         compressionMeter.setValue(meterValue);
         inputMeter.setValue(threshold + 5.0f);  // Show input relative to threshold
         outputMeter.setValue(meterValue + makeup);
+        
+        updateQCLabel();
     }
 
 private:
@@ -373,9 +389,98 @@ private:
     
     // Reference to the processor state
     AudioProcessorValueTreeState& processorState;
+    
+    // QC statistics from the processor, may be null. The editor is their only event reader.
+    DynamicsStatistics* statistics = nullptr;
+    
+    // The latest overload and NaN events, oldest first
+    static constexpr int maxRecentEvents = 20;
+    StringArray recentEvents;
+    
+    void updateQCLabel()
+    {
+        if (statistics == nullptr)
+            return;
+        
+        drainEvents();
+        
+        // Show the worse of the two channels
+        auto meanGainReduction = 0.0;
+        auto aboveThreshold = 0.0;
+        uint64 limiterEngagements = 0, overloads = 0, nanCount = 0;
+        
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto snapshot = statistics->getChannelSnapshot(channel);
+            meanGainReduction = std::max(meanGainReduction, snapshot.getMeanGainReduction());
+            aboveThreshold = std::max(aboveThreshold, snapshot.getAboveThresholdFraction());
+            limiterEngagements = std::max(limiterEngagements, snapshot.softLimitEngagements);
+            overloads = std::max(overloads, snapshot.overloadEvents);
+            nanCount = std::max(nanCount, snapshot.nanSanitizations);
+        }
+        
+        String text;
+        text << "QC  avg GR " << String(meanGainReduction, 1) << " dB"
+             << "  |  above thr " << String(aboveThreshold * 100.0, 1) << "%"
+             << "  |  limiter " << (int64) limiterEngagements
+             << "  |  overloads " << (int64) overloads;
+        
+        if (nanCount > 0)
+            text << "  |  NaN " << (int64) nanCount;
+        
+        if (! recentEvents.isEmpty())
+            text << "  |  last: " << recentEvents[recentEvents.size() - 1];
+        
+        String tooltip = recentEvents.joinIntoString("\n");
+        
+        if (auto dropped = statistics->getDroppedEventCount())
+            tooltip = String((int64) dropped) + " events dropped while the log was full\n" + tooltip;
+        
+        qcLabel.setText(text, dontSendNotification);
+        qcLabel.setTooltip(tooltip);
+    }
+    
+    /** Move newly logged events into recentEvents, so the log never fills up while
+        the editor is open
+    */
+    void drainEvents()
+    {
+        DynamicsStatistics::Event drained[32];
+        
+        for (;;)
+        {
+            auto numRead = statistics->popEvents(drained, numElementsInArray(drained));
+            
+            for (int i = 0; i < numRead; ++i)
+                recentEvents.add(describeEvent(drained[i]));
+            
+            if (numRead < numElementsInArray(drained))
+                break;
+        }
+        
+        if (recentEvents.size() > maxRecentEvents)
+            recentEvents.removeRange(0, recentEvents.size() - maxRecentEvents);
+    }
+    
+    String describeEvent(const DynamicsStatistics::Event& event) const
+    {
+        auto sampleRate = statistics->getSampleRate();
+        auto seconds = sampleRate > 0.0 ? (double) event.samplePosition / sampleRate : 0.0;
+        
+        String text;
+        
+        if (event.type == DynamicsStatistics::EventType::overload)
+            text << "overload " << String(Decibels::gainToDecibels(event.value), 1) << " dBFS";
+        else
+            text << "NaN x" << event.numSamples;
+        
+        text << " ch " << (event.channel + 1) << " at " << String(seconds, 2) << " s";
+        return text;
+    }
 
     void setupSlider(Slider& slider, const String& labelText, float defaultValue)
     {
+        slider.setName(labelText);
         slider.setSliderStyle(Slider::LinearVertical);
         slider.setTextBoxStyle(Slider::TextBoxBelow, false, 150, 30);
         slider.setColour(Slider::textBoxOutlineColourId, Colours::lightblue.withAlpha(0.5f));
@@ -402,6 +507,7 @@ private:
     
     void setupThresholdSlider(Slider& slider, const String& labelText, float defaultValue)
     {
+        slider.setName(labelText);
         slider.setSliderStyle(Slider::LinearVertical);
         slider.setTextBoxStyle(Slider::TextBoxBelow, false, 150, 30);
         slider.setColour(Slider::textBoxBackgroundColourId, Colours::black.withAlpha(0.7f));
@@ -432,6 +538,7 @@ private:
     
     void setupTimeSlider(Slider& slider, const String& labelText, float defaultValue, float minValue, float maxValue)
     {
+        slider.setName(labelText);
         slider.setSliderStyle(Slider::LinearVertical);
         slider.setTextBoxStyle(Slider::TextBoxBelow, false, 150, 30);
         slider.setColour(Slider::textBoxBackgroundColourId, Colours::black.withAlpha(0.7f));
@@ -465,6 +572,8 @@ private:
     
     void setupRatioComboBox()
     {
+        ratioComboBox.setName("RATIO");
+
         // Add ratio options
         ratioComboBox.addItem("1:1", 1);
         ratioComboBox.addItem("2:1", 2);
@@ -513,6 +622,7 @@ private:
     ComboBox ratioComboBox;
     Label titleLabel;
     Label buildVersionLabel;
+    Label qcLabel;
     LevelMeter compressionMeter{"COMPRESSION"};
     LevelMeter inputMeter{"INPUT"};
     LevelMeter outputMeter{"OUTPUT"};
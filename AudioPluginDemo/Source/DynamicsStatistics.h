@@ -0,0 +1,312 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+//==============================================================================
+/** Programme-level dynamics QC statistics.
+
+    The compressor gathers a BlockSummary per channel while it processes a block,
+    and hands it over here with addChannelBlock(). Everything on the audio thread
+    is O(1) per block: a handful of relaxed atomic stores, one pass over the
+    histogram bins and at most two pushes into the lock-free event log.
+
+    Readers (the editor on the message thread, or the offline renderer) take
+    snapshots with getChannelSnapshot() and drain events with popEvents().
+    There must only be one event reader at a time.
+*/
+class DynamicsStatistics
+{
+public:
+    //==============================================================================
+    static constexpr int maxChannels = 8;
+    static constexpr int numHistogramBins = 61;   // 1 dB bins, 0 dB to 60 dB of gain reduction
+    static constexpr int eventLogSize = 256;
+
+    /** What the compressor saw while processing one channel of one block */
+    struct BlockSummary
+    {
+        int numSamples = 0;
+        int samplesAboveThreshold = 0;
+        int softLimitedSamples = 0;
+        int softLimitOnsets = 0;
+        int overloadSamples = 0;
+        int overloadOnsets = 0;         // overloads that start in this block, not continue into it
+        int firstOverloadOnset = -1;
+        float overloadPeak = 0.0f;
+        int nonFiniteSamples = 0;
+        int firstNonFiniteSample = -1;
+        float peakGainReduction = 0.0f; // largest envelope value in dB
+        std::array<int, numHistogramBins> gainReductionBins {};  // samples per 1 dB bin of the envelope
+
+        /** Count one sample's gain reduction (0 to 60 dB) in its histogram bin */
+        void addToHistogram(float gainReductionDb, int count = 1)
+        {
+            gainReductionBins[(size_t) jlimit(0, numHistogramBins - 1, (int) (gainReductionDb + 0.5f))] += count;
+        }
+    };
+
+    enum class EventType
+    {
+        overload,       // input at or above 0 dBFS
+        nanSanitized    // non-finite input replaced by silence
+    };
+
+    /** An entry in the event log */
+    struct Event
+    {
+        EventType type = EventType::overload;
+        int channel = 0;
+        int64 samplePosition = 0;   // from the start of the programme
+        int numSamples = 0;         // affected samples in the block
+        float value = 0.0f;         // overload peak, unused for NaN events
+    };
+
+    /** A consistent-enough copy of one channel's counters for display or reporting */
+    struct ChannelSnapshot
+    {
+        uint64 totalSamples = 0;
+        uint64 samplesAboveThreshold = 0;
+        uint64 softLimitedSamples = 0;
+        uint64 softLimitEngagements = 0;
+        uint64 overloadEvents = 0;
+        uint64 nanSanitizations = 0;
+        float peakGainReduction = 0.0f;
+        std::array<uint64, numHistogramBins> gainReductionHistogram {};
+
+        double getAboveThresholdFraction() const  { return totalSamples > 0 ? (double) samplesAboveThreshold / (double) totalSamples : 0.0; }
+        double getSaturationFraction() const      { return totalSamples > 0 ? (double) softLimitedSamples / (double) totalSamples : 0.0; }
+
+        /** Mean gain reduction in dB, from the histogram bin centres */
+        double getMeanGainReduction() const
+        {
+            uint64 count = 0;
+            double sum = 0.0;
+
+            for (int bin = 0; bin < numHistogramBins; ++bin)
+            {
+                count += gainReductionHistogram[(size_t) bin];
+                sum += (double) gainReductionHistogram[(size_t) bin] * (double) bin;
+            }
+
+            return count > 0 ? sum / (double) count : 0.0;
+        }
+    };
+
+    //==============================================================================
+    DynamicsStatistics() = default;
+
+    /** Clear everything. Must not be called while the audio thread is writing. */
+    void reset()
+    {
+        for (auto& channel : channels)
+        {
+            channel.totalSamples.store(0, std::memory_order_relaxed);
+            channel.samplesAboveThreshold.store(0, std::memory_order_relaxed);
+            channel.softLimitedSamples.store(0, std::memory_order_relaxed);
+            channel.softLimitEngagements.store(0, std::memory_order_relaxed);
+            channel.overloadEvents.store(0, std::memory_order_relaxed);
+            channel.nanSanitizations.store(0, std::memory_order_relaxed);
+            channel.peakGainReduction.store(0.0f, std::memory_order_relaxed);
+
+            for (auto& bin : channel.histogram)
+                bin.store(0, std::memory_order_relaxed);
+        }
+
+        programmePosition.store(0, std::memory_order_relaxed);
+        droppedEvents.store(0, std::memory_order_relaxed);
+        eventFifo.reset();
+    }
+
+    void setSampleRate(double newSampleRate) { sampleRate = newSampleRate; }
+    double getSampleRate() const             { return sampleRate; }
+
+    //==============================================================================
+    /** Audio thread: accumulate one channel of the current block */
+    void addChannelBlock(int channel, const BlockSummary& summary)
+    {
+        if (channel < 0 || channel >= maxChannels || summary.numSamples <= 0)
+            return;
+
+        auto& stats = channels[(size_t) channel];
+
+        for (int bin = 0; bin < numHistogramBins; ++bin)
+            if (auto count = summary.gainReductionBins[(size_t) bin])
+                addRelaxed(stats.histogram[(size_t) bin], (uint64) count);
+
+        addRelaxed(stats.totalSamples, (uint64) summary.numSamples);
+        addRelaxed(stats.samplesAboveThreshold, (uint64) summary.samplesAboveThreshold);
+        addRelaxed(stats.softLimitedSamples, (uint64) summary.softLimitedSamples);
+        addRelaxed(stats.softLimitEngagements, (uint64) summary.softLimitOnsets);
+
+        if (summary.peakGainReduction > stats.peakGainReduction.load(std::memory_order_relaxed))
+            stats.peakGainReduction.store(summary.peakGainReduction, std::memory_order_relaxed);
+
+        auto blockStart = programmePosition.load(std::memory_order_relaxed);
+
+        if (summary.overloadOnsets > 0)
+        {
+            addRelaxed(stats.overloadEvents, (uint64) summary.overloadOnsets);
+            pushEvent({ EventType::overload, channel, blockStart + summary.firstOverloadOnset,
+                        summary.overloadSamples, summary.overloadPeak });
+        }
+
+        if (summary.nonFiniteSamples > 0)
+        {
+            addRelaxed(stats.nanSanitizations, (uint64) summary.nonFiniteSamples);
+            pushEvent({ EventType::nanSanitized, channel, blockStart + summary.firstNonFiniteSample,
+                        summary.nonFiniteSamples, 0.0f });
+        }
+    }
+
+    /** Audio thread: move the programme position on once all channels of a block are added */
+    void advance(int numSamples)
+    {
+        programmePosition.store(programmePosition.load(std::memory_order_relaxed) + numSamples,
+                                std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    /** Reader: copy the counters of one channel */
+    ChannelSnapshot getChannelSnapshot(int channel) const
+    {
+        ChannelSnapshot snapshot;
+
+        if (channel < 0 || channel >= maxChannels)
+            return snapshot;
+
+        auto& stats = channels[(size_t) channel];
+        snapshot.totalSamples = stats.totalSamples.load(std::memory_order_relaxed);
+        snapshot.samplesAboveThreshold = stats.samplesAboveThreshold.load(std::memory_order_relaxed);
+        snapshot.softLimitedSamples = stats.softLimitedSamples.load(std::memory_order_relaxed);
+        snapshot.softLimitEngagements = stats.softLimitEngagements.load(std::memory_order_relaxed);
+        snapshot.overloadEvents = stats.overloadEvents.load(std::memory_order_relaxed);
+        snapshot.nanSanitizations = stats.nanSanitizations.load(std::memory_order_relaxed);
+        snapshot.peakGainReduction = stats.peakGainReduction.load(std::memory_order_relaxed);
+
+        for (int bin = 0; bin < numHistogramBins; ++bin)
+            snapshot.gainReductionHistogram[(size_t) bin] = stats.histogram[(size_t) bin].load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+    /** Reader: move up to maxEvents logged events into dest, returns how many were read */
+    int popEvents(Event* dest, int maxEvents)
+    {
+        const auto scope = eventFifo.read(maxEvents);
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = events[(size_t) (scope.startIndex1 + i)];
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = events[(size_t) (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    int64 getProgrammePosition() const   { return programmePosition.load(std::memory_order_relaxed); }
+    uint64 getDroppedEventCount() const  { return droppedEvents.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Build a QC report for the given channels, including any events already drained */
+    var createReport(int numChannels, const Array<Event>& loggedEvents) const
+    {
+        auto* report = new DynamicObject();
+        report->setProperty("sampleRate", sampleRate);
+        report->setProperty("totalSamples", getProgrammePosition());
+        report->setProperty("droppedEvents", (int64) getDroppedEventCount());
+
+        Array<var> channelReports;
+
+        for (int channel = 0; channel < jmin(numChannels, maxChannels); ++channel)
+        {
+            auto snapshot = getChannelSnapshot(channel);
+            auto* channelReport = new DynamicObject();
+
+            channelReport->setProperty("secondsAboveThreshold", sampleRate > 0.0 ? (double) snapshot.samplesAboveThreshold / sampleRate : 0.0);
+            channelReport->setProperty("aboveThresholdFraction", snapshot.getAboveThresholdFraction());
+            channelReport->setProperty("meanGainReductionDb", snapshot.getMeanGainReduction());
+            channelReport->setProperty("peakGainReductionDb", snapshot.peakGainReduction);
+            channelReport->setProperty("softLimitEngagements", (int64) snapshot.softLimitEngagements);
+            channelReport->setProperty("saturationActiveFraction", snapshot.getSaturationFraction());
+            channelReport->setProperty("overloadEvents", (int64) snapshot.overloadEvents);
+            channelReport->setProperty("nanSanitizations", (int64) snapshot.nanSanitizations);
+
+            Array<var> histogram;
+            for (auto count : snapshot.gainReductionHistogram)
+                histogram.add((int64) count);
+
+            channelReport->setProperty("gainReductionHistogramDb", histogram);
+            channelReports.add(var(channelReport));
+        }
+
+        report->setProperty("channels", channelReports);
+
+        Array<var> eventReports;
+
+        for (auto& event : loggedEvents)
+        {
+            auto* eventReport = new DynamicObject();
+            eventReport->setProperty("type", event.type == EventType::overload ? "overload" : "nanSanitized");
+            eventReport->setProperty("channel", event.channel);
+            eventReport->setProperty("samplePosition", event.samplePosition);
+            eventReport->setProperty("seconds", sampleRate > 0.0 ? (double) event.samplePosition / sampleRate : 0.0);
+            eventReport->setProperty("numSamples", event.numSamples);
+
+            if (event.type == EventType::overload)
+                eventReport->setProperty("peakDb", 20.0 * std::log10(std::max((double) event.value, 1e-10)));
+
+            eventReports.add(var(eventReport));
+        }
+
+        report->setProperty("events", eventReports);
+
+        return var(report);
+    }
+
+private:
+    //==============================================================================
+    struct ChannelStatistics
+    {
+        std::atomic<uint64> totalSamples { 0 };
+        std::atomic<uint64> samplesAboveThreshold { 0 };
+        std::atomic<uint64> softLimitedSamples { 0 };
+        std::atomic<uint64> softLimitEngagements { 0 };
+        std::atomic<uint64> overloadEvents { 0 };
+        std::atomic<uint64> nanSanitizations { 0 };
+        std::atomic<float> peakGainReduction { 0.0f };
+        std::array<std::atomic<uint64>, numHistogramBins> histogram {};
+    };
+
+    /** Single writer, so a plain load/store pair is enough and avoids a locked add */
+    static void addRelaxed(std::atomic<uint64>& counter, uint64 amount)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    void pushEvent(const Event& event)
+    {
+        const auto scope = eventFifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            events[(size_t) scope.startIndex1] = event;
+        else if (scope.blockSize2 > 0)
+            events[(size_t) scope.startIndex2] = event;
+        else
+            droppedEvents.store(droppedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    std::array<ChannelStatistics, maxChannels> channels;
+    std::atomic<int64> programmePosition { 0 };
+    std::atomic<uint64> droppedEvents { 0 };
+    double sampleRate = 44100.0;
+
+    AbstractFifo eventFifo { eventLogSize };
+    std::array<Event, eventLogSize> events;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DynamicsStatistics)
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <typeinfo>
+#include "CompressorEditor.h"
+
+//==============================================================================
+/** Headless rendering benchmark for the CompressorEditor.
+
+    Paints the editor repeatedly into a software Image, so it needs no window,
+    no message loop and no display. Meters are animated by driving the editor
+    and meter timer callbacks by hand between frames, which matches what the
+    timers would do when the plugin window is open.
+
+    The numbers from this class are the baseline for any GUI rendering change.
+*/
+class EditorRenderBenchmark
+{
+public:
+    //==============================================================================
+    /** Paint cost of a single child component */
+    struct ComponentCost
+    {
+        String name;
+        Rectangle<int> bounds;
+        double msPerFrame = 0.0;
+    };
+
+    /** Result of one benchmark configuration */
+    struct Result
+    {
+        int width = 0;
+        int height = 0;
+        float scale = 1.0f;
+        int numFrames = 0;
+        double msPerFrame = 0.0;
+        double worstFrameMs = 0.0;
+        Array<ComponentCost> componentCosts;
+    };
+
+    //==============================================================================
+    explicit EditorRenderBenchmark(CompressorEditor& editorToMeasure)
+        : editor(editorToMeasure)
+    {
+    }
+
+    /** Run one configuration: resize the editor, then paint it numFrames times */
+    Result run(int width, int height, float scale, int numFrames)
+    {
+        editor.setSize(width, height);
+
+        Result result;
+        result.width = editor.getWidth();
+        result.height = editor.getHeight();
+        result.scale = scale;
+        result.numFrames = numFrames;
+
+        Image image(Image::ARGB,
+                    roundToInt((float) result.width * scale),
+                    roundToInt((float) result.height * scale),
+                    true, SoftwareImageType());
+
+        // Warm up font and gradient caches so the first frame doesn't skew the average
+        paintFrame(image, scale);
+
+        auto totalMs = 0.0;
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            advanceAnimation();
+
+            auto startMs = Time::getMillisecondCounterHiRes();
+            paintFrame(image, scale);
+            auto frameMs = Time::getMillisecondCounterHiRes() - startMs;
+
+            totalMs += frameMs;
+            result.worstFrameMs = std::max(result.worstFrameMs, frameMs);
+        }
+
+        result.msPerFrame = numFrames > 0 ? totalMs / numFrames : 0.0;
+        result.componentCosts = measureComponents(scale, numFrames);
+
+        return result;
+    }
+
+    /** Run the standard set of configurations: 1x and 2x at both resize limits */
+    Array<Result> runStandardSuite(int numFrames)
+    {
+        Array<Result> results;
+
+        for (auto scale : { 1.0f, 2.0f })
+        {
+            results.add(run(700, 700, scale, numFrames));
+            results.add(run(1200, 1000, scale, numFrames));
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    /** Format a result as a human readable report */
+    static String formatResult(const Result& result)
+    {
+        String report;
+        report << result.width << "x" << result.height << " @ " << String(result.scale, 1) << "x: "
+               << String(result.msPerFrame, 3) << " ms/frame (worst " << String(result.worstFrameMs, 3)
+               << " ms, " << result.numFrames << " frames)" << newLine;
+
+        for (auto& cost : result.componentCosts)
+        {
+            report << "    " << cost.name.paddedRight(' ', 28)
+                   << String(cost.msPerFrame, 3).paddedLeft(' ', 9) << " ms  ("
+                   << cost.bounds.toString() << ")" << newLine;
+        }
+
+        return report;
+    }
+
+private:
+    //==============================================================================
+    void paintFrame(Image& image, float scale)
+    {
+        paintComponent(editor, image, scale);
+    }
+
+    static void paintComponent(Component& component, Image& image, float scale)
+    {
+        image.clear(image.getBounds());
+
+        Graphics g(image);
+        g.addTransform(AffineTransform::scale(scale));
+        component.paintEntireComponent(g, true);
+    }
+
+    /** Step the editor and meter timers the same way the real timers would */
+    void advanceAnimation()
+    {
+        editor.timerCallback();
+
+        for (auto* child : editor.getChildren())
+            if (auto* meter = dynamic_cast<LevelMeter*>(child))
+                meter->timerCallback();
+    }
+
+    Array<ComponentCost> measureComponents(float scale, int numFrames)
+    {
+        Array<ComponentCost> costs;
+
+        for (auto* child : editor.getChildren())
+        {
+            if (! child->isVisible() || child->getBounds().isEmpty())
+                continue;
+
+            Image image(Image::ARGB,
+                        std::max(1, roundToInt((float) child->getWidth() * scale)),
+                        std::max(1, roundToInt((float) child->getHeight() * scale)),
+                        true, SoftwareImageType());
+
+            // Same warm-up as the full frame: the first paint of each child fills its caches
+            paintComponent(*child, image, scale);
+
+            auto totalMs = 0.0;
+
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                advanceAnimation();
+
+                auto startMs = Time::getMillisecondCounterHiRes();
+                paintComponent(*child, image, scale);
+                totalMs += Time::getMillisecondCounterHiRes() - startMs;
+            }
+
+            costs.add({ describe(*child), child->getBounds(), numFrames > 0 ? totalMs / numFrames : 0.0 });
+        }
+
+        return costs;
+    }
+
+    static String describe(Component& component)
+    {
+        if (auto* label = dynamic_cast<Label*>(&component))
+            return "Label \"" + label->getText() + "\"";
+
+        if (component.getName().isNotEmpty())
+            return component.getName();
+
+        return typeid(component).name();
+    }
+
+    //==============================================================================
+    CompressorEditor& editor;
+
+    JUCE_DECLARE_NON_COPYABLE(EditorRenderBenchmark)
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** Re-blocks a host's irregular buffers into fixed-size internal blocks.
+
+    Host samples go into a fill block and come out of the previously processed
+    block at the same position. Every time the fill block is full it is processed
+    in one go, and the two blocks swap roles. The output is therefore delayed by
+    exactly getLatencySamples() samples whatever the host's block pattern, and the
+    DSP only ever sees full blocks of the chosen size.
+
+    Nothing is allocated after prepare().
+*/
+template <typename FloatType>
+class FixedBlockBuffer
+{
+public:
+    //==============================================================================
+    FixedBlockBuffer() = default;
+
+    /** Allocate the blocks. Call before processing, not on the audio thread. */
+    void prepare(int numChannels, int newBlockSize)
+    {
+        blockSize = jmax(1, newBlockSize);
+
+        for (auto& block : blocks)
+            block.setSize(jmax(1, numChannels), blockSize);
+
+        reset();
+    }
+
+    /** Drop anything buffered; the output restarts with blockSize samples of silence */
+    void reset()
+    {
+        for (auto& block : blocks)
+            block.clear();
+
+        fillPosition = 0;
+        fillIndex = 0;
+    }
+
+    int getBlockSize() const        { return blockSize; }
+    int getLatencySamples() const   { return blockSize; }
+
+    //==============================================================================
+    /** Run one host buffer through, in place.
+
+        processBlock is called with an AudioBuffer<FloatType>& holding exactly
+        getBlockSize() samples, once for every block that fills up during this call.
+    */
+    template <typename ProcessBlock>
+    void process(AudioBuffer<FloatType>& hostBuffer, ProcessBlock&& processBlock)
+    {
+        auto numChannels = jmin(hostBuffer.getNumChannels(), blocks[0].getNumChannels());
+        auto numSamples = hostBuffer.getNumSamples();
+
+        for (int position = 0; position < numSamples;)
+        {
+            auto& fill = blocks[fillIndex];
+            auto& processed = blocks[1 - fillIndex];
+            auto chunk = jmin(numSamples - position, blockSize - fillPosition);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* host = hostBuffer.getWritePointer(channel, position);
+                FloatVectorOperations::copy(fill.getWritePointer(channel, fillPosition), host, chunk);
+                FloatVectorOperations::copy(host, processed.getReadPointer(channel, fillPosition), chunk);
+            }
+
+            position += chunk;
+            fillPosition += chunk;
+
+            if (fillPosition == blockSize)
+            {
+                processBlock(fill);
+                fillIndex = 1 - fillIndex;
+                fillPosition = 0;
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    AudioBuffer<FloatType> blocks[2];
+    int blockSize = 0;
+    int fillPosition = 0;
+    int fillIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FixedBlockBuffer)
+};
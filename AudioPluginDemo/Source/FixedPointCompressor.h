@@ -0,0 +1,378 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+//==============================================================================
+/** Fixed-point version of the SimpleCompressor signal path for FPU-less targets.
+
+    Processes int16 (Q15) or int32 (Q31) buffers directly. The per-sample path uses
+    only integer adds, multiplies (32x32 -> 64), shifts and a count-leading-zeros,
+    so results are bit-exact and deterministic on every platform. The log2, exp2 and
+    tanh lookup tables are hardcoded rather than generated with libm.
+
+    Internal formats:
+      - levels, threshold, envelope and gains in dB: Q8.24 (signed 32-bit)
+      - attack/release coefficients: Q2.30
+      - linear gain: Q4.27, so the +20 dB gain limit (x10) fits
+      - samples are widened to 64-bit Q31 between the gain and the soft limiter,
+        because the float path can reach 10x full scale before it soft limits
+
+    Parameters are set with floats at control rate. That only uses IEEE basic
+    arithmetic and rounding (no transcendental functions), so the coefficients
+    come out identical everywhere, including on soft-float builds.
+
+    Error against the float SimpleCompressor (measured by
+    fixed_point_error_analysis.cpp over sines, noise and release tails at
+    44.1/48/96 kHz across all ratio presets):
+      - detector level (log2 table, linear interpolation): < 0.002 dB
+      - applied gain (exp2 table, linear interpolation):   < 0.002 dB
+      - soft limiter (tanh table over [0, 8], 1/32 steps): < 1e-4 of full scale
+      - envelope:                                          < 0.01 dB
+      - Q31 output sample:                                 < 2e-4 of full scale
+      - Q15 output sample:                                 < 8 LSB
+    Samples within 1e-3 of the soft-limit knee (0.95) are excluded, because the
+    float limiter is discontinuous there and any rounding can flip the branch.
+
+    Like SimpleCompressor, one instance shares its envelope across all channels.
+    Relies on arithmetic right shifts of negative values, which every supported
+    compiler implements (and C++20 guarantees).
+*/
+class FixedPointCompressor
+{
+public:
+    //==============================================================================
+    FixedPointCompressor() = default;
+    ~FixedPointCompressor() = default;
+
+    FixedPointCompressor(const FixedPointCompressor&) = delete;
+    FixedPointCompressor& operator=(const FixedPointCompressor&) = delete;
+
+    //==============================================================================
+    /** Prepare the compressor for playback */
+    void prepareToPlay(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        updateCoefficients();
+        reset();
+    }
+
+    /** Reset the compressor state */
+    void reset()
+    {
+        envelope = 0;
+    }
+
+    /** Set compressor parameters, in the same units and with the same limits as SimpleCompressor */
+    void setParameters(float newThreshold, float newRatio, float newAttack,
+                       float newRelease, float newMakeupGain)
+    {
+        // Clamp the threshold so (level - threshold) always fits Q8.24
+        threshold = dbToFixed(std::max(-100.0f, std::min(20.0f, newThreshold)));
+        slope = static_cast<int32_t>(std::llround((1.0 - 1.0 / std::max(newRatio, 1.0f)) * (double) oneQ24));
+        attack = std::max(newAttack, 0.1f);
+        release = std::max(newRelease, 1.0f);
+        makeupGain = dbToFixed(std::max(-60.0f, std::min(60.0f, newMakeupGain)));
+
+        updateCoefficients();
+    }
+
+    //==============================================================================
+    /** Process a single Q31 sample */
+    int32_t processSample(int32_t input)
+    {
+        // Detector level in dB
+        auto inputLevel = levelInDb(input);
+
+        // Gain reduction
+        int32_t gainReduction = 0;
+
+        if (inputLevel > threshold)
+        {
+            auto overThreshold = static_cast<int64_t>(inputLevel) - threshold;
+            gainReduction = static_cast<int32_t>(std::min<int64_t>(roundShift(overThreshold * slope, 24), maxGainReduction));
+        }
+
+        // Attack/release envelope
+        auto coeff = gainReduction > envelope ? attackCoeff : releaseCoeff;
+        envelope += static_cast<int32_t>(roundShift(static_cast<int64_t>(gainReduction - envelope) * coeff, 30));
+        envelope = std::max<int32_t>(0, std::min(maxGainReduction, envelope));
+
+        // Gain in dB, limited like the float path, then to linear Q4.27
+        auto gainInDb = std::max(minGainDb, std::min(maxGainDb, makeupGain - envelope));
+        auto gain = dbToLinearGain(gainInDb);
+
+        // Apply gain in a widened Q31 so the limiter sees the same overs as the float path
+        auto output = roundShift(static_cast<int64_t>(input) * gain, 27);
+
+        if (output > softLimitThreshold || output < -softLimitThreshold)
+            output = softLimit(output);
+
+        return saturate32(output);
+    }
+
+    /** Process Q15 or Q31 channel buffers in place */
+    template <typename SampleType>
+    void processBlock(SampleType* const* channels, int numChannels, int numSamples)
+    {
+        static_assert(std::is_same<SampleType, int16_t>::value || std::is_same<SampleType, int32_t>::value,
+                      "FixedPointCompressor processes int16 (Q15) or int32 (Q31) samples");
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = channels[channel];
+
+            for (int sample = 0; sample < numSamples; ++sample)
+                data[sample] = fromQ31<SampleType>(processSample(toQ31(data[sample])));
+        }
+    }
+
+    //==============================================================================
+    /** Current envelope in dB (Q8.24) */
+    int32_t getCurrentEnvelope() const   { return envelope; }
+
+    /** Convert a Q8.24 dB value back to float, for metering and testing */
+    static float fixedToDb(int32_t value)  { return static_cast<float>(value) / static_cast<float>(oneQ24); }
+
+    static int32_t dbToFixed(float db)     { return static_cast<int32_t>(std::llround((double) db * (double) oneQ24)); }
+
+    //==============================================================================
+    // The table-driven stages of processSample(), public so each one can be
+    // checked against its float counterpart
+
+    /** 20 * log10(|x|) for a Q31 sample, clamped to [-120, 20] dB, in Q8.24 */
+    static int32_t levelInDb(int32_t sample)
+    {
+        auto magnitude = sample < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(sample))
+                                    : static_cast<uint32_t>(sample);
+
+        if (magnitude == 0)
+            return minLevelDb;
+
+        // log2(magnitude) = msb + log2(1 + fraction), with the mantissa from a 32-step table
+        auto msb = 31 - countLeadingZeros(magnitude);
+        auto mantissa = (magnitude << (31 - msb)) & 0x7fffffffu;
+        auto index = static_cast<int>(mantissa >> 26);
+        auto remainder = static_cast<int64_t>(mantissa & 0x3ffffffu);
+
+        auto log2Value = static_cast<int64_t>(msb - 31) * oneQ24 + log2Table[index]
+                       + ((static_cast<int64_t>(log2Table[index + 1] - log2Table[index]) * remainder) >> 26);
+
+        auto levelDb = roundShift(log2Value * dbPerOctave, 24);
+        return static_cast<int32_t>(std::max<int64_t>(minLevelDb, std::min<int64_t>(maxLevelDb, levelDb)));
+    }
+
+    /** 10^(dB / 20) as a Q4.27 gain, for dB in [-60, 20] (Q8.24) */
+    static int32_t dbToLinearGain(int32_t gainInDb)
+    {
+        auto octaves = roundShift(static_cast<int64_t>(gainInDb) * octavesPerDb, 24);
+        auto wholeOctaves = static_cast<int>(octaves >> 24);                // floor
+        auto fraction = static_cast<int64_t>(octaves & (oneQ24 - 1));
+        auto index = static_cast<int>(fraction >> 19);
+        auto remainder = fraction & 0x7ffff;
+
+        // 2^fraction in Q29
+        auto mantissa = exp2Table[index] + ((static_cast<int64_t>(exp2Table[index + 1] - exp2Table[index]) * remainder) >> 19);
+
+        // Q29 -> Q27 is two places to the right, then scale by the whole octaves
+        auto shift = wholeOctaves - 2;
+        auto gain = shift >= 0 ? mantissa << shift : roundShift(mantissa, -shift);
+
+        return static_cast<int32_t>(gain);
+    }
+
+    /** tanh(x * 0.8) * 0.95 for a widened Q31 sample */
+    static int64_t softLimit(int64_t sample)
+    {
+        auto magnitude = sample < 0 ? -sample : sample;
+        auto argument = (magnitude * 4) / 5;                                // x * 0.8, Q31
+        auto index = static_cast<int>(std::min<int64_t>(argument >> 26, tanhTableSize - 1));
+        auto remainder = argument & 0x3ffffff;
+
+        int64_t limited = tanhTable[index];
+
+        if (index < tanhTableSize - 1)
+            limited += (static_cast<int64_t>(tanhTable[index + 1] - tanhTable[index]) * remainder) >> 26;
+
+        limited = roundShift(limited * softLimitCeiling, 30);
+        return sample < 0 ? -limited : limited;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int32_t oneQ24 = 1 << 24;
+    static constexpr int64_t oneQ30 = int64_t(1) << 30;
+    static constexpr int32_t maxGainReduction = 60 * oneQ24;
+    static constexpr int32_t minGainDb = -60 * oneQ24;
+    static constexpr int32_t maxGainDb = 20 * oneQ24;
+    static constexpr int32_t minLevelDb = -120 * oneQ24;
+    static constexpr int32_t maxLevelDb = 20 * oneQ24;
+    static constexpr int64_t dbPerOctave = 101008905;      // 20 * log10(2) in Q24
+    static constexpr int64_t octavesPerDb = 2786635;       // 1 / (20 * log10(2)) in Q24
+    static constexpr int64_t softLimitThreshold = 2040109466; // 0.95 in Q31
+    static constexpr int64_t softLimitCeiling = 1020054733;   // 0.95 in Q30
+
+    //==============================================================================
+    static int64_t roundShift(int64_t value, int shift)
+    {
+        return (value + (int64_t(1) << (shift - 1))) >> shift;
+    }
+
+    static int32_t saturate32(int64_t value)
+    {
+        return static_cast<int32_t>(std::max<int64_t>(std::numeric_limits<int32_t>::min(),
+                                                       std::min<int64_t>(std::numeric_limits<int32_t>::max(), value)));
+    }
+
+    static int countLeadingZeros(uint32_t value)
+    {
+       #if defined (__GNUC__) || defined (__clang__)
+        return __builtin_clz(value);
+       #else
+        int count = 0;
+        for (uint32_t mask = 0x80000000u; (value & mask) == 0; mask >>= 1)
+            ++count;
+        return count;
+       #endif
+    }
+
+    static int32_t toQ31(int32_t sample)   { return sample; }
+    static int32_t toQ31(int16_t sample)   { return static_cast<int32_t>(sample) * 65536; }
+
+    template <typename SampleType>
+    static SampleType fromQ31(int32_t sample)
+    {
+        if (std::is_same<SampleType, int32_t>::value)
+            return static_cast<SampleType>(sample);
+
+        auto rounded = roundShift(sample, 16);
+        return static_cast<SampleType>(std::max<int64_t>(-32768, std::min<int64_t>(32767, rounded)));
+    }
+
+    //==============================================================================
+    /** 1 - exp(-1 / timeInSamples) in Q30, from the power series so no libm is involved */
+    int32_t timeToCoefficient(float milliseconds) const
+    {
+        auto samplesQ16 = std::llround((double) milliseconds * 0.001 * sampleRate * 65536.0);
+        samplesQ16 = std::max<long long>(samplesQ16, 65536);                // at least one sample
+
+        auto u = (int64_t(1) << 46) / samplesQ16;                            // 1 / samples, Q30
+        int64_t term = u;
+        int64_t coefficient = 0;
+
+        for (int k = 1; k <= 10 && term != 0; ++k)
+        {
+            coefficient += (k % 2 == 1) ? term : -term;
+            term = ((term * u) >> 30) / (k + 1);
+        }
+
+        return static_cast<int32_t>(std::max<int64_t>(1, std::min<int64_t>(oneQ30, coefficient)));
+    }
+
+    void updateCoefficients()
+    {
+        if (sampleRate > 0.0)
+        {
+            attackCoeff = timeToCoefficient(attack);
+            releaseCoeff = timeToCoefficient(release);
+        }
+    }
+
+    //==============================================================================
+    static constexpr int32_t log2Table[33] =        // log2(1 + i / 32), Q24
+    {
+        0, 744810, 1467383, 2169009, 2850868, 3514044,
+        4159533, 4788255, 5401057, 5998727, 6581994, 7151536,
+        7707984, 8251926, 8783912, 9304457, 9814042, 10313120,
+        10802114, 11281425, 11751428, 12212479, 12664911, 13109041,
+        13545168, 13973576, 14394532, 14808293, 15215099, 15615181,
+        16008758, 16396036, 16777216
+    };
+
+    static constexpr int32_t exp2Table[33] =        // 2^(i / 32), Q29
+    {
+        536870912, 548626854, 560640218, 572916640, 585461881, 598281827,
+        611382493, 624770026, 638450708, 652430958, 666717336, 681316545,
+        696235434, 711481005, 727060411, 742980960, 759250125, 775875538,
+        792865000, 810226483, 827968132, 846098274, 864625413, 883558244,
+        902905651, 922676710, 942880699, 963527098, 984625594, 1006186087,
+        1028218693, 1050733751, 1073741824
+    };
+
+    static constexpr int tanhTableSize = 257;
+    static constexpr int32_t tanhTable[tanhTableSize] =  // tanh(i / 32), Q31
+    {
+        0, 67087027, 134043238, 200738834, 267046038,
+        332840059, 398000016, 462409793, 525958823, 588542781,
+        650064194, 710432940, 769566653, 827391017, 883839965,
+        938855767, 992389039, 1044398644, 1094851532, 1143722488,
+        1190993835, 1236655069, 1280702458, 1323138607, 1363971989,
+        1403216471, 1440890820, 1477018219, 1511625774, 1544744046,
+        1576406585, 1606649491, 1635510996, 1663031067, 1689251036,
+        1714213263, 1737960815, 1760537185, 1781986033, 1802350947,
+        1821675246, 1840001788, 1857372819, 1873829831, 1889413451,
+        1904163334, 1918118093, 1931315227, 1943791074, 1955580771,
+        1966718233, 1977236130, 1987165888, 1996537682, 2005380453,
+        2013721914, 2021588576, 2029005763, 2035997648, 2042587275,
+        2048796596, 2054646501, 2060156855, 2065346536, 2070233464,
+        2074834649, 2079166216, 2083243450, 2087080830, 2090692061,
+        2094090114, 2097287257, 2100295089, 2103124571, 2105786059,
+        2108289334, 2110643629, 2112857658, 2114939645, 2116897344,
+        2118738072, 2120468724, 2122095801, 2123625428, 2125063379,
+        2126415091, 2127685686, 2128879988, 2130002540, 2131057616,
+        2132049242, 2132981208, 2133857079, 2134680210, 2135453758,
+        2136180694, 2136863812, 2137505741, 2138108952, 2138675772,
+        2139208386, 2139708851, 2140179101, 2140620954, 2141036119,
+        2141426204, 2141792720, 2142137087, 2142460640, 2142764634,
+        2143050249, 2143318595, 2143570713, 2143807583, 2144030125,
+        2144239206, 2144435637, 2144620183, 2144793563, 2144956451,
+        2145109482, 2145253251, 2145388318, 2145515209, 2145634419,
+        2145746413, 2145851627, 2145950471, 2146043330, 2146130567,
+        2146212522, 2146289514, 2146361844, 2146429794, 2146493629,
+        2146553598, 2146609936, 2146662861, 2146712581, 2146759290,
+        2146803170, 2146844392, 2146883117, 2146919496, 2146953672,
+        2146985778, 2147015939, 2147044273, 2147070891, 2147095897,
+        2147119387, 2147141455, 2147162186, 2147181661, 2147199956,
+        2147217143, 2147233289, 2147248457, 2147262705, 2147276091,
+        2147288666, 2147300479, 2147311576, 2147322001, 2147331794,
+        2147340994, 2147349637, 2147357756, 2147365383, 2147372548,
+        2147379279, 2147385602, 2147391543, 2147397123, 2147402365,
+        2147407290, 2147411916, 2147416262, 2147420345, 2147424180,
+        2147427783, 2147431167, 2147434347, 2147437334, 2147440140,
+        2147442776, 2147445252, 2147447579, 2147449764, 2147451817,
+        2147453745, 2147455557, 2147457259, 2147458858, 2147460360,
+        2147461771, 2147463096, 2147464341, 2147465511, 2147466610,
+        2147467642, 2147468612, 2147469523, 2147470379, 2147471183,
+        2147471938, 2147472647, 2147473314, 2147473940, 2147474528,
+        2147475081, 2147475600, 2147476087, 2147476545, 2147476976,
+        2147477380, 2147477760, 2147478117, 2147478452, 2147478766,
+        2147479062, 2147479340, 2147479601, 2147479846, 2147480077,
+        2147480293, 2147480496, 2147480687, 2147480867, 2147481035,
+        2147481193, 2147481342, 2147481482, 2147481613, 2147481736,
+        2147481852, 2147481961, 2147482063, 2147482159, 2147482249,
+        2147482334, 2147482414, 2147482489, 2147482559, 2147482625,
+        2147482687, 2147482745, 2147482800, 2147482851, 2147482899,
+        2147482945, 2147482987, 2147483027, 2147483065, 2147483100,
+        2147483133, 2147483165
+    };
+
+    //==============================================================================
+    // Parameters
+    int32_t threshold = -20 * oneQ24;     // dB, Q8.24
+    int32_t slope = 12582912;             // 1 - 1/ratio, Q24 (4:1)
+    float attack = 10.0f;                 // milliseconds
+    float release = 100.0f;               // milliseconds
+    int32_t makeupGain = 0;               // dB, Q8.24
+
+    // Coefficients, Q2.30
+    int32_t attackCoeff = 0;
+    int32_t releaseCoeff = 0;
+
+    // State
+    int32_t envelope = 0;                 // dB, Q8.24
+    double sampleRate = 44100.0;
+};
@@ -0,0 +1,453 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+
+//==============================================================================
+/** A compact, seekable file holding the per-sample gain reduction a render applied.
+
+    The gain reduction is what SimpleCompressor's gain reduction tap records:
+    the final gain relative to the makeup gain, including the gain limits and
+    the soft limiter. A sample's applied gain is makeup - reduction dB, with the
+    makeup gain stored in the header.
+
+    The curve is cut into blocks of a fixed number of samples. Each block stores,
+    per channel:
+
+    - the decimation factor D, as a varint
+    - the number of points, as a varint
+    - the points themselves: the gain reduction at offsets 0, D, 2D ... and at
+      the block's last sample, quantised to quantisationStep dB
+
+    The first point is stored as a zigzag varint and the rest as zigzag varint
+    deltas. The writer picks the largest D (up to maxDecimation) for which linear
+    interpolation between the points stays within the error bound of the exact
+    curve. Release tails and sustained overloads shrink to a handful of bytes,
+    while transients fall back to every sample.
+
+    A footer index holds each block's file offset. A reader can decode any time
+    range by reading only the blocks it overlaps.
+
+    All values are little-endian. Layout:
+    header, blocks..., index (int64 per block), trailer (index offset, length, block count, magic)
+*/
+namespace GainEnvelopeFormat
+{
+    static constexpr int magic = 0x564e4547;     // "GENV"
+    static constexpr int version = 1;
+    static constexpr int maxDecimation = 256;
+
+    inline void writeVarint(MemoryOutputStream& out, uint32 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+
+        out.writeByte(static_cast<char>(value));
+    }
+
+    inline uint32 readVarint(const uint8*& data, const uint8* end)
+    {
+        uint32 value = 0;
+
+        for (int shift = 0; data < end && shift < 35; shift += 7)
+        {
+            auto byte = *data++;
+            value |= static_cast<uint32>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                break;
+        }
+
+        return value;
+    }
+
+    inline uint32 zigzag(int value)      { return (static_cast<uint32>(value) << 1) ^ static_cast<uint32>(value >> 31); }
+    inline int unzigzag(uint32 value)    { return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1); }
+
+    /** Sample offset of point k in a block of numSamples with decimation factor */
+    inline int pointOffset(int k, int decimation, int numSamples)    { return jmin(k * decimation, numSamples - 1); }
+
+    inline int numPoints(int decimation, int numSamples)
+    {
+        return numSamples <= 1 ? 1 : (numSamples - 1) / decimation + 1 + ((numSamples - 1) % decimation != 0 ? 1 : 0);
+    }
+
+    /** Linear interpolation of quantised points back to numSamples values in dB */
+    inline void reconstruct(const int* points, int decimation, int numSamples, float step, float* dest)
+    {
+        auto count = numPoints(decimation, numSamples);
+        dest[0] = static_cast<float>(points[0]) * step;
+
+        for (int k = 1; k < count; ++k)
+        {
+            auto start = pointOffset(k - 1, decimation, numSamples);
+            auto end = pointOffset(k, decimation, numSamples);
+            auto from = static_cast<float>(points[k - 1]) * step;
+            auto to = static_cast<float>(points[k]) * step;
+            auto slope = (to - from) / static_cast<float>(end - start);
+
+            for (int i = start + 1; i <= end; ++i)
+                dest[i] = from + slope * static_cast<float>(i - start);
+        }
+    }
+}
+
+//==============================================================================
+/** Streams gain-reduction blocks to a sidecar file while a render runs.
+    The block and encoding buffers are allocated once and reused for every block.
+*/
+class GainEnvelopeWriter
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        int blockSize = 4096;               // samples per seekable block
+        float quantisationStep = 0.001f;    // dB per stored step
+        float maxErrorDb = 0.01f;           // worst interpolation error allowed
+    };
+
+    //==============================================================================
+    GainEnvelopeWriter(const File& file, double sampleRate, int numChannelsToWrite, float makeupGainDb,
+                       const Options& optionsToUse)
+        : options(optionsToUse),
+          numChannels(jmax(1, numChannelsToWrite)),
+          pending(numChannels, jmax(1, optionsToUse.blockSize)),
+          points((size_t) pending.getNumSamples()),
+          reconstruction((size_t) pending.getNumSamples())
+    {
+        options.blockSize = pending.getNumSamples();
+        options.quantisationStep = jmax(1.0e-6f, options.quantisationStep);
+        options.maxErrorDb = jmax(options.maxErrorDb, options.quantisationStep * 0.5f);
+
+        file.deleteFile();
+        stream = std::make_unique<FileOutputStream>(file);
+
+        if (stream->failedToOpen())
+        {
+            stream = nullptr;
+            return;
+        }
+
+        stream->writeInt(GainEnvelopeFormat::magic);
+        stream->writeInt(GainEnvelopeFormat::version);
+        stream->writeDouble(sampleRate);
+        stream->writeInt(numChannels);
+        stream->writeInt(options.blockSize);
+        stream->writeFloat(options.quantisationStep);
+        stream->writeFloat(options.maxErrorDb);
+        stream->writeFloat(makeupGainDb);
+    }
+
+    bool openedOk() const { return stream != nullptr; }
+
+    /** Append numSamples of gain reduction (dB, positive = reduction) per channel */
+    void write(const AudioBuffer<float>& gainReduction, int numSamples)
+    {
+        if (stream == nullptr)
+            return;
+
+        for (int position = 0; position < numSamples;)
+        {
+            auto chunk = jmin(numSamples - position, options.blockSize - numPending);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                FloatVectorOperations::copy(pending.getWritePointer(channel, numPending),
+                                            gainReduction.getReadPointer(jmin(channel, gainReduction.getNumChannels() - 1), position),
+                                            chunk);
+
+            position += chunk;
+            numPending += chunk;
+
+            if (numPending == options.blockSize)
+                flushBlock();
+        }
+    }
+
+    /** Write the last partial block, the block index and the trailer */
+    bool finish()
+    {
+        if (stream == nullptr)
+            return false;
+
+        if (numPending > 0)
+            flushBlock();
+
+        auto indexOffset = stream->getPosition();
+
+        for (auto offset : blockOffsets)
+            stream->writeInt64(offset);
+
+        stream->writeInt64(indexOffset);
+        stream->writeInt64(totalSamples);
+        stream->writeInt((int) blockOffsets.size());
+        stream->writeInt(GainEnvelopeFormat::magic);
+        stream->flush();
+
+        auto ok = stream->getStatus().wasOk();
+        stream = nullptr;
+        return ok;
+    }
+
+private:
+    //==============================================================================
+    void flushBlock()
+    {
+        blockOffsets.push_back(stream->getPosition());
+        encoded.reset();
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            encodeChannel(pending.getReadPointer(channel), numPending);
+
+        stream->write(encoded.getData(), encoded.getDataSize());
+        totalSamples += numPending;
+        numPending = 0;
+    }
+
+    /** Pick the coarsest decimation within the error bound, then delta-encode its points */
+    void encodeChannel(const float* values, int numSamples)
+    {
+        auto step = options.quantisationStep;
+        auto decimation = GainEnvelopeFormat::maxDecimation;
+
+        for (;; decimation /= 2)
+        {
+            auto count = GainEnvelopeFormat::numPoints(decimation, numSamples);
+
+            for (int k = 0; k < count; ++k)
+                points[(size_t) k] = roundToInt(values[GainEnvelopeFormat::pointOffset(k, decimation, numSamples)] / step);
+
+            if (decimation == 1)
+                break;
+
+            GainEnvelopeFormat::reconstruct(points.data(), decimation, numSamples, step, reconstruction.data());
+
+            auto withinBound = true;
+
+            for (int i = 0; i < numSamples && withinBound; ++i)
+                withinBound = std::abs(reconstruction[(size_t) i] - values[i]) <= options.maxErrorDb;
+
+            if (withinBound)
+                break;
+        }
+
+        auto count = GainEnvelopeFormat::numPoints(decimation, numSamples);
+        GainEnvelopeFormat::writeVarint(encoded, (uint32) decimation);
+        GainEnvelopeFormat::writeVarint(encoded, (uint32) count);
+        GainEnvelopeFormat::writeVarint(encoded, GainEnvelopeFormat::zigzag(points[0]));
+
+        for (int k = 1; k < count; ++k)
+            GainEnvelopeFormat::writeVarint(encoded, GainEnvelopeFormat::zigzag(points[(size_t) k] - points[(size_t) k - 1]));
+    }
+
+    //==============================================================================
+    Options options;
+    int numChannels;
+    std::unique_ptr<FileOutputStream> stream;
+
+    AudioBuffer<float> pending;
+    int numPending = 0;
+    std::vector<int> points;
+    std::vector<float> reconstruction;
+    MemoryOutputStream encoded;
+
+    std::vector<int64> blockOffsets;
+    int64 totalSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GainEnvelopeWriter)
+};
+
+//==============================================================================
+/** Random-access reader for files written by GainEnvelopeWriter.
+    Only the blocks a read overlaps are loaded and decoded.
+*/
+class GainEnvelopeReader
+{
+public:
+    //==============================================================================
+    explicit GainEnvelopeReader(const File& file)
+        : stream(file)
+    {
+        if (stream.failedToOpen() || stream.getTotalLength() < headerSize + trailerSize)
+            return;
+
+        if (stream.readInt() != GainEnvelopeFormat::magic || stream.readInt() != GainEnvelopeFormat::version)
+            return;
+
+        sampleRate = stream.readDouble();
+        numChannels = stream.readInt();
+        blockSize = stream.readInt();
+        quantisationStep = stream.readFloat();
+        maxErrorDb = stream.readFloat();
+        makeupGainDb = stream.readFloat();
+
+        stream.setPosition(stream.getTotalLength() - trailerSize);
+        auto indexOffset = stream.readInt64();
+        lengthInSamples = stream.readInt64();
+        auto numBlocks = stream.readInt();
+
+        if (stream.readInt() != GainEnvelopeFormat::magic || numChannels <= 0 || blockSize <= 0 || numBlocks < 0
+             || indexOffset < headerSize || indexOffset + 8 * (int64) numBlocks + trailerSize != stream.getTotalLength())
+            return;
+
+        // Every block but the last is full, and the last holds at least one sample
+        if (lengthInSamples < 0 || lengthInSamples > (int64) numBlocks * blockSize
+             || (numBlocks > 0 && lengthInSamples <= (int64) (numBlocks - 1) * blockSize)
+             || (numBlocks == 0 && lengthInSamples != 0))
+            return;
+
+        stream.setPosition(indexOffset);
+
+        // Blocks follow the header back to back, so each offset must lie after
+        // the previous one and before the index: the last block ends at the index
+        auto previousEnd = headerSize;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            auto offset = stream.readInt64();
+
+            if (block == 0 ? offset != headerSize : offset <= previousEnd)
+                return;
+
+            blockOffsets.push_back(offset);
+            previousEnd = offset;
+        }
+
+        if (numBlocks > 0 ? previousEnd >= indexOffset : indexOffset != headerSize)
+            return;
+
+        blockOffsets.push_back(indexOffset); // end of the last block
+        decoded.setSize(numChannels, blockSize);
+        points.resize((size_t) blockSize);
+        valid = true;
+    }
+
+    bool openedOk() const               { return valid; }
+    double getSampleRate() const        { return sampleRate; }
+    int getNumChannels() const          { return numChannels; }
+    int64 getLengthInSamples() const    { return lengthInSamples; }
+    float getMaxErrorDb() const         { return maxErrorDb; }
+    float getMakeupGainDb() const       { return makeupGainDb; }
+
+    /** Read gain reduction in dB for any range. Samples outside the file read as 0.
+        dest needs getNumChannels() channels (extra channels are left alone).
+    */
+    bool read(AudioBuffer<float>& dest, int destStartSample, int64 startSample, int numSamples)
+    {
+        if (! valid)
+            return false;
+
+        auto channelsToRead = jmin(numChannels, dest.getNumChannels());
+
+        for (int done = 0; done < numSamples;)
+        {
+            auto position = startSample + done;
+            auto block = position >= 0 ? position / blockSize : -1;
+            auto offsetInBlock = position >= 0 ? static_cast<int>(position % blockSize) : 0;
+            auto chunk = position < 0 ? static_cast<int>(jmin<int64>(-position, numSamples - done))
+                                      : jmin(numSamples - done, blockSize - offsetInBlock);
+
+            if (block < 0 || block >= (int64) blockOffsets.size() - 1)
+            {
+                for (int channel = 0; channel < channelsToRead; ++channel)
+                    dest.clear(channel, destStartSample + done, chunk);
+            }
+            else
+            {
+                if (! decodeBlock((int) block))
+                    return false;
+
+                auto available = jmax(0, jmin(chunk, decodedLength - offsetInBlock));
+
+                for (int channel = 0; channel < channelsToRead; ++channel)
+                {
+                    FloatVectorOperations::copy(dest.getWritePointer(channel, destStartSample + done),
+                                                decoded.getReadPointer(channel, offsetInBlock), available);
+
+                    if (available < chunk)
+                        dest.clear(channel, destStartSample + done + available, chunk - available);
+                }
+            }
+
+            done += chunk;
+        }
+
+        return true;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int64 headerSize = 36;
+    static constexpr int64 trailerSize = 24;
+
+    bool decodeBlock(int block)
+    {
+        if (block == decodedBlock)
+            return true;
+
+        decodedBlock = -1;
+        auto blockBytes = static_cast<size_t>(blockOffsets[(size_t) block + 1] - blockOffsets[(size_t) block]);
+
+        if (! stream.setPosition(blockOffsets[(size_t) block]))
+            return false;
+
+        encoded.ensureSize(blockBytes);
+
+        if (stream.read(encoded.getData(), (int) blockBytes) != (int) blockBytes)
+            return false;
+
+        auto* data = static_cast<const uint8*>(encoded.getData());
+        auto* end = data + blockBytes;
+        auto lastBlock = block == (int) blockOffsets.size() - 2;
+        decodedLength = lastBlock ? static_cast<int>(lengthInSamples - (int64) block * blockSize) : blockSize;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto decimation = static_cast<int>(GainEnvelopeFormat::readVarint(data, end));
+            auto count = static_cast<int>(GainEnvelopeFormat::readVarint(data, end));
+
+            if (decimation < 1 || count != GainEnvelopeFormat::numPoints(decimation, decodedLength))
+                return false;
+
+            auto value = GainEnvelopeFormat::unzigzag(GainEnvelopeFormat::readVarint(data, end));
+            points[0] = value;
+
+            for (int k = 1; k < count; ++k)
+            {
+                value += GainEnvelopeFormat::unzigzag(GainEnvelopeFormat::readVarint(data, end));
+                points[(size_t) k] = value;
+            }
+
+            GainEnvelopeFormat::reconstruct(points.data(), decimation, decodedLength, quantisationStep,
+                                            decoded.getWritePointer(channel));
+        }
+
+        decodedBlock = block;
+        return true;
+    }
+
+    //==============================================================================
+    FileInputStream stream;
+    bool valid = false;
+
+    double sampleRate = 0.0;
+    int numChannels = 0;
+    int blockSize = 0;
+    float quantisationStep = 0.0f;
+    float maxErrorDb = 0.0f;
+    float makeupGainDb = 0.0f;
+    int64 lengthInSamples = 0;
+    std::vector<int64> blockOffsets;
+
+    MemoryBlock encoded;
+    AudioBuffer<float> decoded;
+    std::vector<int> points;
+    int decodedBlock = -1;
+    int decodedLength = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GainEnvelopeReader)
+};
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <functional>
+
+class HibernationWorker;
+
+//==============================================================================
+/** Puts an idle plugin instance to sleep and wakes it up again.
+
+    The audio thread calls processBlock() once per block with the block's peak
+    level and whether the DSP state has settled. While awake that is the peak the
+    DSP measured anyway, passed after processing; only while isAsleep() does the
+    caller scan the input itself, before deciding whether to run the DSP at all.
+    After a configurable stretch of
+    silence with a settled envelope it asks for hibernation: from then on the
+    caller runs its cheap passthrough path, and a shared HibernationWorker thread
+    releases the instance's resources. As soon as the input rises above the
+    silence floor the controller asks for a wake-up. The caller goes back to full
+    processing on its small pre-reserved fallbacks straight away, and the worker
+    re-acquires the real resources in the background. Only once they are back
+    does isAwake() return true again.
+
+    The audio thread only touches atomics here; it never allocates, frees or
+    waits for the worker.
+
+    Hibernation saves CPU rather than memory. In AudioPluginDemo the only thing
+    released is the realtime log ring's record buffer, about 32 KB (1024 records
+    of 32 bytes): SimpleCompressor keeps no other per-instance buffers.
+*/
+class HibernationController
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        float silenceThresholdDb = -90.0f;    // block peak below this counts as silence
+        double hibernateAfterSeconds = 10.0;  // silence needed before hibernating
+    };
+
+    /** Called on the worker thread. Return false to be retried on the next poll,
+        e.g. when a buffer can't be released yet because it still holds data.
+    */
+    using ResourceCallback = std::function<bool()>;
+
+    //==============================================================================
+    HibernationController(ResourceCallback releaseCallback, ResourceCallback reacquireCallback)
+        : releaseResources(std::move(releaseCallback)),
+          reacquireResources(std::move(reacquireCallback))
+    {
+    }
+
+    void setOptions(const Options& newOptions)  { options = newOptions; }
+    void prepare(double newSampleRate)          { sampleRate = newSampleRate; silentSamples = 0; }
+
+    //==============================================================================
+    /** Audio thread: update the state for this block.
+        Returns true if the block can take the passthrough path.
+    */
+    bool processBlock(float blockPeak, bool stateSettled, int numSamples)
+    {
+        auto isSilent = blockPeak < Decibels::decibelsToGain(options.silenceThresholdDb);
+        auto current = state.load(std::memory_order_acquire);
+
+        if (current == active)
+        {
+            silentSamples = (isSilent && stateSettled) ? silentSamples + numSamples : 0;
+
+            if (silentSamples >= static_cast<int64>(options.hibernateAfterSeconds * sampleRate))
+            {
+                state.store(releaseRequested, std::memory_order_release);
+                return true;
+            }
+
+            return false;
+        }
+
+        if (current == releaseRequested || current == hibernating)
+        {
+            if (isSilent)
+                return true;
+
+            // Wake up ahead of the resources: this block runs on the fallbacks
+            state.store(wakeRequested, std::memory_order_release);
+            silentSamples = 0;
+        }
+
+        return false;
+    }
+
+    /** Audio thread: true once the real resources are in place again */
+    bool isAwake() const            { return state.load(std::memory_order_acquire) == active; }
+    bool isHibernating() const      { return state.load(std::memory_order_acquire) == hibernating; }
+
+    /** Audio thread: true while blocks may take the passthrough path, i.e. once
+        hibernation has been asked for and until the input comes back
+    */
+    bool isAsleep() const
+    {
+        auto current = state.load(std::memory_order_acquire);
+        return current == releaseRequested || current == hibernating;
+    }
+
+private:
+    //==============================================================================
+    friend class HibernationWorker;
+
+    enum State
+    {
+        active,
+        releaseRequested,
+        hibernating,
+        wakeRequested
+    };
+
+    /** Worker thread: act on whatever the audio thread asked for */
+    void service()
+    {
+        auto current = state.load(std::memory_order_acquire);
+
+        if (current == releaseRequested && ! resourcesReleased)
+        {
+            if (! releaseResources())
+                return;
+
+            resourcesReleased = true;
+            auto expected = static_cast<int>(releaseRequested);
+            state.compare_exchange_strong(expected, hibernating, std::memory_order_acq_rel);
+        }
+        else if (current == wakeRequested)
+        {
+            if (resourcesReleased)
+            {
+                if (! reacquireResources())
+                    return;
+
+                resourcesReleased = false;
+            }
+
+            state.store(active, std::memory_order_release);
+        }
+    }
+
+    //==============================================================================
+    ResourceCallback releaseResources, reacquireResources;
+    Options options;
+    double sampleRate = 44100.0;
+
+    std::atomic<int> state { active };
+    int64 silentSamples = 0;            // audio thread only
+    bool resourcesReleased = false;     // worker thread only
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HibernationController)
+};
+
+//==============================================================================
+/** The background thread that releases and re-acquires resources for every
+    registered HibernationController. Share one per process with
+    SharedResourcePointer<HibernationWorker>.
+*/
+class HibernationWorker : private Thread
+{
+public:
+    //==============================================================================
+    HibernationWorker() : Thread("Hibernation worker")
+    {
+        startThread(Priority::low);
+    }
+
+    ~HibernationWorker() override
+    {
+        stopThread(2000);
+    }
+
+    /** Message thread: start servicing a controller */
+    void addController(HibernationController* controller)
+    {
+        const ScopedLock sl(lock);
+        controllers.addIfNotAlreadyThere(controller);
+    }
+
+    /** Message thread: stop servicing a controller, waking it if it was asleep */
+    void removeController(HibernationController* controller)
+    {
+        const ScopedLock sl(lock);
+
+        if (controller->resourcesReleased)
+        {
+            controller->state.store(HibernationController::wakeRequested);
+            controller->service();
+        }
+
+        controllers.removeFirstMatchingValue(controller);
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const ScopedLock sl(lock);
+
+                for (auto* controller : controllers)
+                    controller->service();
+            }
+
+            // A short poll interval: waking is covered by the fallbacks meanwhile
+            wait(20);
+        }
+    }
+
+    CriticalSection lock;
+    Array<HibernationController*> controllers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HibernationWorker)
+};
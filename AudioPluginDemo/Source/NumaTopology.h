@@ -0,0 +1,228 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#if JUCE_LINUX
+ #include <sched.h>
+ #include <pthread.h>
+ #include <unistd.h>
+ #include <sys/mman.h>
+ #include <sys/syscall.h>
+#endif
+
+//==============================================================================
+/** NUMA topology of the machine, and helpers to keep a worker and its memory on one node.
+
+    On Linux the topology comes from /sys/devices/system/node. Everywhere else, and on
+    machines without NUMA, it reports a single node holding every CPU. In that case
+    pinning and binding are no-ops.
+*/
+class NumaTopology
+{
+public:
+    //==============================================================================
+    struct Node
+    {
+        int id = 0;
+        Array<int> cpus;
+    };
+
+    /** Read the topology of this machine */
+    static NumaTopology detect()
+    {
+        NumaTopology topology;
+
+       #if JUCE_LINUX
+        auto nodeRoot = File("/sys/devices/system/node");
+
+        for (auto& nodeDirectory : nodeRoot.findChildFiles(File::findDirectories, false, "node*"))
+        {
+            auto idText = nodeDirectory.getFileName().fromFirstOccurrenceOf("node", false, false);
+
+            if (! idText.containsOnly("0123456789"))
+                continue;
+
+            Node node;
+            node.id = idText.getIntValue();
+            node.cpus = parseCpuList(nodeDirectory.getChildFile("cpulist").loadFileAsString());
+
+            if (! node.cpus.isEmpty())
+                topology.nodes.add(node);
+        }
+
+        std::sort(topology.nodes.begin(), topology.nodes.end(),
+                  [](const Node& a, const Node& b) { return a.id < b.id; });
+       #endif
+
+        if (topology.nodes.isEmpty())
+        {
+            Node node;
+
+            for (int cpu = 0; cpu < SystemStats::getNumCpus(); ++cpu)
+                node.cpus.add(cpu);
+
+            topology.nodes.add(node);
+        }
+
+        return topology;
+    }
+
+    const Array<Node>& getNodes() const  { return nodes; }
+    int getNumNodes() const              { return nodes.size(); }
+    bool isNuma() const                  { return nodes.size() > 1; }
+
+    //==============================================================================
+    /** Restrict the calling thread to the CPUs of one node. Returns false if unsupported. */
+    static bool pinCurrentThreadToNode(const Node& node)
+    {
+       #if JUCE_LINUX
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+
+        for (auto cpu : node.cpus)
+            if (cpu >= 0 && cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &cpuSet);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+       #else
+        ignoreUnused(node);
+        return false;
+       #endif
+    }
+
+    /** Parse a sysfs cpu list such as "0-15,32-47" */
+    static Array<int> parseCpuList(const String& text)
+    {
+        Array<int> cpus;
+
+        for (auto& range : StringArray::fromTokens(text.trim(), ",", {}))
+        {
+            if (range.containsChar('-'))
+            {
+                auto first = range.upToFirstOccurrenceOf("-", false, false).getIntValue();
+                auto last = range.fromFirstOccurrenceOf("-", false, false).getIntValue();
+
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpus.add(cpu);
+            }
+            else if (range.isNotEmpty())
+            {
+                cpus.add(range.getIntValue());
+            }
+        }
+
+        return cpus;
+    }
+
+private:
+    Array<Node> nodes;
+};
+
+//==============================================================================
+/** A block of memory whose pages live on one NUMA node, optionally on huge pages.
+
+    On Linux the memory is mapped anonymously, bound to the node with mbind() and
+    touched straight away, so every page is faulted in on that node. If binding
+    isn't possible (no NUMA, or a kernel without the syscall) the touch still gives
+    node-local pages through first-touch, as long as the caller is pinned to the node.
+    Elsewhere it is a plain zeroed heap block.
+*/
+class NodeLocalBuffer
+{
+public:
+    //==============================================================================
+    NodeLocalBuffer(size_t numBytesNeeded, int nodeId, bool useHugePages)
+    {
+       #if JUCE_LINUX
+        static constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+        if (useHugePages)
+        {
+            numBytes = (numBytesNeeded + hugePageSize - 1) & ~(hugePageSize - 1);
+            auto* mapped = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if (mapped != MAP_FAILED)
+            {
+                data = mapped;
+                isMapped = true;
+                onHugePages = true;
+            }
+        }
+
+        if (data == nullptr)
+        {
+            numBytes = jmax<size_t>(1, numBytesNeeded);
+            auto* mapped = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (mapped != MAP_FAILED)
+            {
+                data = mapped;
+                isMapped = true;
+
+                // No reserved huge pages, so ask for transparent ones instead
+                if (useHugePages)
+                    madvise(data, numBytes, MADV_HUGEPAGE);
+            }
+        }
+
+        if (data != nullptr)
+        {
+            bindToNode(nodeId);
+            std::memset(data, 0, numBytes); // fault every page in now, on this node
+            return;
+        }
+       #else
+        ignoreUnused(nodeId, useHugePages);
+       #endif
+
+        numBytes = jmax<size_t>(1, numBytesNeeded);
+        heapBlock.calloc(numBytes);
+        data = heapBlock.get();
+    }
+
+    ~NodeLocalBuffer()
+    {
+       #if JUCE_LINUX
+        if (isMapped)
+            munmap(data, numBytes);
+       #endif
+    }
+
+    void* getData() const        { return data; }
+    size_t getSize() const       { return numBytes; }
+    bool isOnHugePages() const   { return onHugePages; }
+    bool isBoundToNode() const   { return boundToNode; }
+
+private:
+    //==============================================================================
+    void bindToNode(int nodeId)
+    {
+       #if JUCE_LINUX && defined (SYS_mbind)
+        static constexpr int mpolBind = 2;
+        static constexpr int bitsPerWord = 8 * (int) sizeof(unsigned long);
+
+        if (nodeId < 0 || nodeId >= 16 * bitsPerWord)
+            return;
+
+        unsigned long nodeMask[16] = {};
+        nodeMask[nodeId / bitsPerWord] = 1ul << (nodeId % bitsPerWord);
+
+        boundToNode = syscall(SYS_mbind, data, numBytes, mpolBind, nodeMask,
+                              (unsigned long) (16 * bitsPerWord), 0u) == 0;
+       #else
+        ignoreUnused(nodeId);
+       #endif
+    }
+
+    //==============================================================================
+    void* data = nullptr;
+    size_t numBytes = 0;
+    bool isMapped = false;
+    bool onHugePages = false;
+    bool boundToNode = false;
+    HeapBlock<char> heapBlock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NodeLocalBuffer)
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "SimpleCompressor.h"
+#include "DynamicsStatistics.h"
+#include "GainEnvelopeSidecar.h"
+
+//==============================================================================
+/** Renders audio files through the SimpleCompressor without a host.
+
+    Uses the same DSP as the plugin, with the same single compressor instance
+    shared across channels, so offline output matches what the plugin produces.
+    Optionally writes a per-file QC report and the applied gain-reduction curve
+    (see GainEnvelopeWriter) next to each output.
+*/
+class OfflineRenderer
+{
+public:
+    //==============================================================================
+    /** Compressor and render settings, in the same units as the plugin parameters */
+    struct Settings
+    {
+        float threshold = -20.0f;     // dB
+        float ratio = 4.0f;           // compression ratio
+        float attack = 10.0f;         // milliseconds
+        float release = 100.0f;       // milliseconds
+        float makeupGain = 0.0f;      // dB
+
+        int blockSize = 512;          // samples per processBuffer() call
+        int bitsPerSample = 24;       // output file bit depth
+        bool writeQCReport = true;    // write <output file name>.qc.json next to the output, e.g. out.wav.qc.json
+        bool writeGainEnvelope = false;         // write <output file name>.grenv next to the output, e.g. out.wav.grenv
+        float gainEnvelopeMaxErrorDb = 0.01f;   // interpolation error allowed in the .grenv
+    };
+
+    //==============================================================================
+    OfflineRenderer()
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    /** Render one file. The output format is chosen from the output file extension. */
+    Result renderFile(const File& inputFile, const File& outputFile, const Settings& settings)
+    {
+        AudioBuffer<float> noWorkBuffer;
+        return renderFile(inputFile, outputFile, settings, noWorkBuffer);
+    }
+
+    /** Render one file using the caller's work buffer for audio I/O.
+
+        The work buffer needs at least as many channels as the input file and at
+        least settings.blockSize samples. It can refer to external memory, such as
+        a NodeLocalBuffer, and is never reallocated. An empty work buffer means
+        the renderer allocates its own.
+    */
+    Result renderFile(const File& inputFile, const File& outputFile, const Settings& settings,
+                      AudioBuffer<float>& workBuffer)
+    {
+        if (settings.blockSize <= 0)
+            return Result::fail("Invalid block size " + String(settings.blockSize) + " for " + inputFile.getFullPathName());
+
+        std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(inputFile));
+
+        if (reader == nullptr)
+            return Result::fail("Could not read " + inputFile.getFullPathName());
+
+        AudioBuffer<float> ownBuffer;
+        auto* ioBuffer = &workBuffer;
+
+        if (workBuffer.getNumChannels() == 0)
+        {
+            ownBuffer.setSize(static_cast<int>(reader->numChannels), settings.blockSize);
+            ioBuffer = &ownBuffer;
+        }
+
+        if (static_cast<int>(reader->numChannels) > ioBuffer->getNumChannels()
+             || settings.blockSize > ioBuffer->getNumSamples())
+            return Result::fail("Work buffer too small for " + inputFile.getFullPathName());
+
+        std::unique_ptr<AudioFormatWriter> writer;
+        auto writerResult = createWriter(outputFile, *reader, settings, writer);
+
+        if (writerResult.failed())
+            return writerResult;
+
+        auto numChannels = static_cast<int>(reader->numChannels);
+
+        SimpleCompressor compressor;
+        DynamicsStatistics statistics;
+        Array<DynamicsStatistics::Event> events;
+
+        // Same FTZ/DAZ protection as the plugin's processBlock, for fading tails
+        ScopedNoDenormals noDenormals;
+
+        prepareCompressor(compressor, statistics, settings, reader->sampleRate);
+
+        std::unique_ptr<GainEnvelopeWriter> envelopeWriter;
+        AudioBuffer<float> gainReduction;
+        auto envelopeResult = createGainEnvelopeWriter(outputFile, settings, reader->sampleRate, numChannels,
+                                                       compressor, gainReduction, envelopeWriter);
+
+        if (envelopeResult.failed())
+            return envelopeResult;
+
+        for (int64 position = 0; position < reader->lengthInSamples; position += settings.blockSize)
+        {
+            auto numSamples = static_cast<int>(std::min<int64>(settings.blockSize, reader->lengthInSamples - position));
+            AudioBuffer<float> buffer(ioBuffer->getArrayOfWritePointers(), numChannels, 0, numSamples);
+
+            if (! reader->read(&buffer, 0, numSamples, position, true, true))
+                return Result::fail("Read error in " + inputFile.getFullPathName());
+
+            compressor.processBuffer(buffer);
+            drainEvents(statistics, events);
+
+            if (envelopeWriter != nullptr)
+                envelopeWriter->write(gainReduction, numSamples);
+
+            if (! writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+                return Result::fail("Write error in " + outputFile.getFullPathName());
+        }
+
+        writer = nullptr;
+
+        if (envelopeWriter != nullptr && ! envelopeWriter->finish())
+            return Result::fail("Could not write gain envelope for " + outputFile.getFullPathName());
+
+        if (settings.writeQCReport)
+            return writeQCReport(statistics, numChannels, events, inputFile, outputFile);
+
+        return Result::ok();
+    }
+
+    /** Where the QC report for an output file is written, e.g. out.wav.qc.json.
+        Like the gain envelope, it keeps the full file name.
+    */
+    static File getQCReportFile(const File& outputFile)
+    {
+        return outputFile.getSiblingFile(outputFile.getFileName() + ".qc.json");
+    }
+
+    /** Where the gain-reduction envelope for an output file is written. The full
+        file name is kept, so a.wav and a.flac get separate envelopes.
+    */
+    static File getGainEnvelopeFile(const File& outputFile)
+    {
+        return outputFile.getSiblingFile(outputFile.getFileName() + ".grenv");
+    }
+
+    AudioFormatManager& getFormatManager() { return formatManager; }
+
+    //==============================================================================
+    // The pieces of renderFile() that other render paths share
+
+    /** Create a writer for the output file matching the reader's rate and channels */
+    Result createWriter(const File& outputFile, const AudioFormatReader& reader, const Settings& settings,
+                        std::unique_ptr<AudioFormatWriter>& writer)
+    {
+        auto* format = formatManager.findFormatForFileExtension(outputFile.getFileExtension());
+
+        if (format == nullptr)
+            return Result::fail("No audio format for " + outputFile.getFullPathName());
+
+        outputFile.deleteFile();
+        std::unique_ptr<OutputStream> stream(outputFile.createOutputStream());
+
+        if (stream == nullptr)
+            return Result::fail("Could not create " + outputFile.getFullPathName());
+
+        writer.reset(format->createWriterFor(stream.get(), reader.sampleRate, reader.numChannels,
+                                             settings.bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+            return Result::fail("Could not create a writer for " + outputFile.getFullPathName());
+
+        stream.release(); // the writer owns the stream now
+        return Result::ok();
+    }
+
+    static void prepareCompressor(SimpleCompressor& compressor, DynamicsStatistics& statistics,
+                                  const Settings& settings, double sampleRate)
+    {
+        compressor.prepareToPlay(sampleRate);
+        compressor.setParameters(settings.threshold, settings.ratio, settings.attack,
+                                 settings.release, settings.makeupGain);
+
+        statistics.setSampleRate(sampleRate);
+        statistics.reset();
+        compressor.setStatistics(&statistics);
+    }
+
+    /** If the settings ask for it, open the gain envelope sidecar and tap the
+        compressor's gain reduction into gainReduction, one block at a time
+    */
+    static Result createGainEnvelopeWriter(const File& outputFile, const Settings& settings, double sampleRate,
+                                           int numChannels, SimpleCompressor& compressor,
+                                           AudioBuffer<float>& gainReduction,
+                                           std::unique_ptr<GainEnvelopeWriter>& envelopeWriter)
+    {
+        if (! settings.writeGainEnvelope)
+            return Result::ok();
+
+        GainEnvelopeWriter::Options options;
+        options.maxErrorDb = settings.gainEnvelopeMaxErrorDb;
+
+        envelopeWriter = std::make_unique<GainEnvelopeWriter>(getGainEnvelopeFile(outputFile), sampleRate,
+                                                              numChannels, settings.makeupGain, options);
+
+        if (! envelopeWriter->openedOk())
+            return Result::fail("Could not create gain envelope for " + outputFile.getFullPathName());
+
+        gainReduction.setSize(numChannels, jmax(1, settings.blockSize));
+        compressor.setGainReductionTap(&gainReduction);
+        return Result::ok();
+    }
+
+    static Result writeQCReport(const DynamicsStatistics& statistics, int numChannels,
+                                const Array<DynamicsStatistics::Event>& events,
+                                const File& inputFile, const File& outputFile)
+    {
+        auto report = statistics.createReport(numChannels, events);
+
+        if (auto* object = report.getDynamicObject())
+        {
+            object->setProperty("input", inputFile.getFullPathName());
+            object->setProperty("output", outputFile.getFullPathName());
+        }
+
+        if (! getQCReportFile(outputFile).replaceWithText(JSON::toString(report)))
+            return Result::fail("Could not write QC report for " + outputFile.getFullPathName());
+
+        return Result::ok();
+    }
+
+    /** Move the QC events queued by the audio thread into events */
+    static void drainEvents(DynamicsStatistics& statistics, Array<DynamicsStatistics::Event>& events)
+    {
+        DynamicsStatistics::Event drained[32];
+
+        for (;;)
+        {
+            auto numRead = statistics.popEvents(drained, numElementsInArray(drained));
+
+            if (numRead == 0)
+                break;
+
+            events.addArray(drained, numRead);
+        }
+    }
+
+private:
+    //==============================================================================
+    AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
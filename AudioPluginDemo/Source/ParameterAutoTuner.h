@@ -0,0 +1,601 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <vector>
+#include <numeric>
+#include "SimpleCompressor.h"
+#include "DynamicsStatistics.h"
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/** Offline search for compressor settings that hit target dynamics metrics.
+
+    Every candidate on a coarse grid (ratio presets x threshold x attack x release)
+    is rendered in parallel on a decimated proxy of the file. Only the best few
+    candidates are then rendered at the full sample rate, and the best of those
+    is the result.
+
+    The proxy has two paths. The compressor runs on one that keeps the
+    largest-magnitude sample of each group of samples, so the peak detector sees
+    roughly the same peaks it would at full rate. Those peaks overstate the
+    signal's energy, which would bias every loudness figure upwards, so loudness
+    is measured on a second path holding the RMS of each group: it has exactly
+    the energy of the full-rate audio in every measurement window. The gain the
+    compressor applied, read from its gain reduction tap, is replayed onto that
+    path. Time constants are preserved by preparing the proxy compressor at the
+    proxy sample rate.
+
+    A constant makeup gain moves peak and loudness together, so none of the
+    metrics depend on it (short of the soft limiter) and it isn't searched. With
+    Options::matchLoudness the best candidates instead get the makeup gain that
+    brings their integrated loudness back to the input's, and their full-rate
+    renders, which include the soft limiter, are made with it.
+
+    Each pool worker renders its candidates block by block through its scratch
+    buffers and measures them on the fly, so memory doesn't grow with the number
+    of candidates in flight.
+
+    Loudness figures are unweighted (no K-weighting filter), but are gated the
+    same way as EBU R128 / Tech 3342, which is good enough for ranking settings.
+    Measurement windows are whole numbers of 100 ms segments.
+*/
+class ParameterAutoTuner
+{
+public:
+    //==============================================================================
+    /** Dynamics metrics of a rendered signal */
+    struct Metrics
+    {
+        float loudnessRange = 0.0f;         // LU, 10th to 95th percentile of short-term loudness
+        float peakToLoudnessRatio = 0.0f;   // dB, sample peak minus integrated loudness
+        float maxGainReduction = 0.0f;      // dB, peak of the compressor envelope
+        float integratedLoudness = 0.0f;    // dB, unweighted
+    };
+
+    /** What the tuner should aim for. A weight of zero ignores that metric. */
+    struct Targets
+    {
+        float loudnessRange = 6.0f;
+        float peakToLoudnessRatio = 12.0f;
+        float maxGainReduction = 12.0f;     // treated as a ceiling, not a target
+
+        float loudnessRangeWeight = 1.0f;
+        float peakToLoudnessRatioWeight = 1.0f;
+        float maxGainReductionWeight = 4.0f;
+    };
+
+    struct Options
+    {
+        int proxyDecimation = 4;            // proxy runs at sampleRate / proxyDecimation
+        int numFinalCandidates = 4;         // candidates re-rendered at full rate
+        int numThreads = SystemStats::getNumCpus();
+        int blockSize = 512;
+        bool matchLoudness = true;          // set the makeup gain so the output is as loud as the input
+    };
+
+    /** A set of settings and how well it did */
+    struct Candidate
+    {
+        OfflineRenderer::Settings settings;
+        int ratioPreset = 3;                // index into SimpleCompressor::ratioPresets, settings.ratio follows it
+        Metrics metrics;
+        double cost = 0.0;
+    };
+
+    //==============================================================================
+    ParameterAutoTuner(const Targets& targetsToUse, const Options& optionsToUse)
+        : targets(targetsToUse), options(optionsToUse),
+          pool(jmax(1, optionsToUse.numThreads)),
+          scratch((size_t) jmax(1, optionsToUse.numThreads))
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~ParameterAutoTuner()
+    {
+        pool.removeAllJobs(true, 10000);
+    }
+
+    /** Find the best settings for one file.
+        Call from one thread at a time: the workers' scratch buffers are reused between calls.
+    */
+    Result tuneFile(const File& inputFile, Candidate& best)
+    {
+        std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(inputFile));
+
+        if (reader == nullptr)
+            return Result::fail("Could not read " + inputFile.getFullPathName());
+
+        if (reader->lengthInSamples <= 0 || reader->lengthInSamples > std::numeric_limits<int>::max())
+            return Result::fail("Unsupported length in " + inputFile.getFullPathName());
+
+        auto sampleRate = reader->sampleRate;
+        AudioBuffer<float> audio(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+
+        if (! reader->read(&audio, 0, audio.getNumSamples(), 0, true, true))
+            return Result::fail("Read error in " + inputFile.getFullPathName());
+
+        auto decimation = jmax(1, options.proxyDecimation);
+        auto detectorProxy = createPeakProxy(audio, decimation);
+        auto loudnessProxy = createRMSProxy(audio, decimation);
+        auto proxyRate = sampleRate / decimation;
+
+        // Coarse search on the proxy
+        auto candidates = createCandidateGrid();
+        evaluateInParallel(candidates, detectorProxy, loudnessProxy, proxyRate);
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+        candidates.resize((size_t) jlimit(1, (int) candidates.size(), options.numFinalCandidates));
+
+        if (options.matchLoudness)
+        {
+            auto inputLoudness = measure(audio, sampleRate, 0.0f).integratedLoudness;
+
+            for (auto& candidate : candidates)
+                candidate.settings.makeupGain = jlimit(-30.0f, 30.0f, candidate.settings.makeupGain + inputLoudness
+                                                                        - candidate.metrics.integratedLoudness);
+        }
+
+        // Full-rate renders of the best few
+        evaluateInParallel(candidates, audio, audio, sampleRate);
+
+        best = *std::min_element(candidates.begin(), candidates.end(),
+                                 [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+        return Result::ok();
+    }
+
+    /** Tune every file and write <file name>.params.json for each into outputDirectory,
+        e.g. in.wav.params.json, so files that differ only in extension don't collide.
+
+        A file that fails doesn't stop the batch: the rest are still tuned, and the
+        result lists every failure, one per line.
+    */
+    Result tuneFiles(const Array<File>& inputFiles, const File& outputDirectory)
+    {
+        if (! outputDirectory.createDirectory())
+            return Result::fail("Could not create " + outputDirectory.getFullPathName());
+
+        StringArray failures;
+
+        for (auto& inputFile : inputFiles)
+        {
+            Candidate best;
+            auto result = tuneFile(inputFile, best);
+
+            if (result.failed())
+            {
+                failures.add(result.getErrorMessage());
+                continue;
+            }
+
+            auto outputFile = outputDirectory.getChildFile(inputFile.getFileName() + ".params.json");
+
+            if (! outputFile.replaceWithText(JSON::toString(toJSON(inputFile, best))))
+                failures.add("Could not write " + outputFile.getFullPathName());
+        }
+
+        return failures.isEmpty() ? Result::ok() : Result::fail(failures.joinIntoString("\n"));
+    }
+
+    //==============================================================================
+    /** Measure the dynamics metrics of a rendered signal */
+    static Metrics measure(const AudioBuffer<float>& audio, double sampleRate, float maxGainReduction)
+    {
+        MetricsMeter meter(sampleRate);
+        meter.addBlock(audio);
+        return meter.getMetrics(maxGainReduction);
+    }
+
+    //==============================================================================
+    /** Running dynamics measurement, fed one rendered block at a time.
+
+        Keeps the sample peak and the energy of each 100 ms segment, which is all
+        the gated loudness figures need: a few bytes per second of audio.
+    */
+    class MetricsMeter
+    {
+    public:
+        explicit MetricsMeter(double sampleRate)
+            : segmentLength(jmax(1, roundToInt(0.1 * sampleRate)))
+        {
+        }
+
+        void addBlock(const AudioBuffer<float>& block)
+        {
+            addPeak(block);
+            addEnergy(block);
+        }
+
+        /** Only the sample peak, for audio whose loudness is measured elsewhere */
+        void addPeak(const AudioBuffer<float>& block)
+        {
+            for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                peak = jmax(peak, block.getMagnitude(channel, 0, block.getNumSamples()));
+        }
+
+        /** Only the segment energies that the loudness figures are built from */
+        void addEnergy(const AudioBuffer<float>& block)
+        {
+            auto numSamples = block.getNumSamples();
+
+            for (int start = 0; start < numSamples;)
+            {
+                auto count = jmin(numSamples - start, segmentLength - segmentFill);
+
+                for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                {
+                    auto* data = block.getReadPointer(channel, start);
+
+                    for (int i = 0; i < count; ++i)
+                        segmentEnergy += (double) data[i] * data[i];
+                }
+
+                start += count;
+                segmentFill += count;
+
+                if (segmentFill == segmentLength)
+                {
+                    segmentEnergies.push_back(segmentEnergy);
+                    segmentEnergy = 0.0;
+                    segmentFill = 0;
+                }
+            }
+        }
+
+        Metrics getMetrics(float maxGainReduction) const
+        {
+            Metrics metrics;
+            metrics.maxGainReduction = maxGainReduction;
+            metrics.integratedLoudness = static_cast<float>(integratedLoudness());
+            metrics.peakToLoudnessRatio = static_cast<float>(powerToDb(peak * peak)) - metrics.integratedLoudness;
+            metrics.loudnessRange = static_cast<float>(loudnessRange());
+            return metrics;
+        }
+
+    private:
+        /** Mean square of each window of windowSegments segments, summed over channels.
+            Audio shorter than one window is measured as a single window.
+        */
+        std::vector<double> windowPowers(int windowSegments, int hopSegments) const
+        {
+            std::vector<double> powers;
+            auto numSegments = (int) segmentEnergies.size();
+
+            if (numSegments < windowSegments)
+            {
+                auto numSamples = numSegments * segmentLength + segmentFill;
+                auto energy = std::accumulate(segmentEnergies.begin(), segmentEnergies.end(), segmentEnergy);
+
+                if (numSamples > 0)
+                    powers.push_back(energy / numSamples);
+
+                return powers;
+            }
+
+            for (int start = 0; start + windowSegments <= numSegments; start += hopSegments)
+            {
+                auto energy = std::accumulate(segmentEnergies.begin() + start,
+                                              segmentEnergies.begin() + start + windowSegments, 0.0);
+                powers.push_back(energy / ((double) windowSegments * segmentLength));
+            }
+
+            return powers;
+        }
+
+        /** Unweighted integrated loudness: 400 ms blocks, -70 absolute and -10 relative gates */
+        double integratedLoudness() const
+        {
+            auto powers = windowPowers(4, 1);
+            auto ungated = gatedMean(powers, -70.0);
+
+            return gatedMean(powers, jmax(-70.0, ungated - 10.0));
+        }
+
+        /** Unweighted loudness range: 3 s windows, -70 absolute and -20 relative gates */
+        double loudnessRange() const
+        {
+            auto powers = windowPowers(30, 10);
+            auto relativeGate = jmax(-70.0, gatedMean(powers, -70.0) - 20.0);
+
+            std::vector<double> levels;
+
+            for (auto power : powers)
+                if (powerToDb(power) > relativeGate)
+                    levels.push_back(powerToDb(power));
+
+            if (levels.size() < 2)
+                return 0.0;
+
+            std::sort(levels.begin(), levels.end());
+
+            auto percentile = [&levels](double fraction)
+            {
+                return levels[(size_t) roundToInt(fraction * (double) (levels.size() - 1))];
+            };
+
+            return percentile(0.95) - percentile(0.10);
+        }
+
+        int segmentLength;
+        int segmentFill = 0;
+        double segmentEnergy = 0.0;
+        std::vector<double> segmentEnergies;
+        float peak = 0.0f;
+    };
+
+    static var toJSON(const File& inputFile, const Candidate& candidate)
+    {
+        auto* settings = new DynamicObject();
+        settings->setProperty("threshold", candidate.settings.threshold);
+        settings->setProperty("ratio", candidate.settings.ratio);
+        settings->setProperty("attack", candidate.settings.attack);
+        settings->setProperty("release", candidate.settings.release);
+        settings->setProperty("makeupGain", candidate.settings.makeupGain);
+
+        auto* metrics = new DynamicObject();
+        metrics->setProperty("loudnessRange", candidate.metrics.loudnessRange);
+        metrics->setProperty("peakToLoudnessRatio", candidate.metrics.peakToLoudnessRatio);
+        metrics->setProperty("maxGainReduction", candidate.metrics.maxGainReduction);
+        metrics->setProperty("integratedLoudness", candidate.metrics.integratedLoudness);
+
+        auto* result = new DynamicObject();
+        result->setProperty("input", inputFile.getFullPathName());
+        result->setProperty("settings", var(settings));
+        result->setProperty("metrics", var(metrics));
+        result->setProperty("cost", candidate.cost);
+
+        return var(result);
+    }
+
+private:
+    //==============================================================================
+    std::vector<Candidate> createCandidateGrid() const
+    {
+        static const float attackTimes[] = { 2.0f, 10.0f, 30.0f };
+        static const float releaseTimes[] = { 50.0f, 150.0f, 400.0f };
+
+        std::vector<Candidate> candidates;
+
+        for (int preset = 0; preset < SimpleCompressor::numRatioPresets; ++preset)
+        {
+            auto ratio = SimpleCompressor::ratioPresets[(size_t) preset];
+
+            // At 1:1 (preset 0) threshold and time constants change nothing: one candidate is enough
+            if (preset == 0)
+            {
+                Candidate candidate;
+                candidate.ratioPreset = preset;
+                candidate.settings.ratio = ratio;
+                candidate.settings.blockSize = options.blockSize;
+                candidates.push_back(candidate);
+                continue;
+            }
+
+            for (auto threshold = -40.0f; threshold <= -4.0f; threshold += 2.0f)
+                for (auto attack : attackTimes)
+                    for (auto release : releaseTimes)
+                    {
+                        Candidate candidate;
+                        candidate.ratioPreset = preset;
+                        candidate.settings.threshold = threshold;
+                        candidate.settings.ratio = ratio;
+                        candidate.settings.attack = attack;
+                        candidate.settings.release = release;
+                        candidate.settings.blockSize = options.blockSize;
+                        candidates.push_back(candidate);
+                    }
+        }
+
+        return candidates;
+    }
+
+    /** A pool worker's render buffers */
+    struct Scratch
+    {
+        AudioBuffer<float> block;
+        AudioBuffer<float> gainReduction;   // the compressor's tap, for the loudness path
+    };
+
+    /** Render every candidate on the thread pool and fill in metrics and cost.
+        One job per worker takes candidates off a shared counter until none are left.
+
+        The compressor runs on audio and loudness is measured on loudnessAudio,
+        which at full rate is the same buffer (see evaluate()).
+    */
+    void evaluateInParallel(std::vector<Candidate>& candidates, const AudioBuffer<float>& audio,
+                            const AudioBuffer<float>& loudnessAudio, double sampleRate)
+    {
+        auto numCandidates = static_cast<int>(candidates.size());
+        auto numWorkers = jmin(numCandidates, (int) scratch.size());
+        std::atomic<int> nextCandidate { 0 };
+        std::atomic<int> remaining { numWorkers };
+        WaitableEvent finished;
+
+        for (int worker = 0; worker < numWorkers; ++worker)
+        {
+            auto& buffers = scratch[(size_t) worker];
+            buffers.block.setSize(audio.getNumChannels(), jmax(1, options.blockSize), false, false, true);
+            buffers.gainReduction.setSize(audio.getNumChannels(), jmax(1, options.blockSize), false, false, true);
+
+            pool.addJob([this, &candidates, &buffers, &audio, &loudnessAudio, sampleRate, numCandidates,
+                         &nextCandidate, &remaining, &finished]
+            {
+                for (auto index = nextCandidate++; index < numCandidates; index = nextCandidate++)
+                    evaluate(candidates[(size_t) index], audio, loudnessAudio, sampleRate, buffers);
+
+                if (--remaining == 0)
+                    finished.signal();
+            });
+        }
+
+        if (numWorkers > 0)
+            finished.wait();
+    }
+
+    /** Render one candidate through the scratch buffers, measuring as it goes.
+
+        When loudnessSource is a separate buffer, the peak is measured on the
+        compressor's output and loudness on loudnessSource with the compressor's
+        applied gain replayed onto it, sample by sample.
+    */
+    void evaluate(Candidate& candidate, const AudioBuffer<float>& source, const AudioBuffer<float>& loudnessSource,
+                  double sampleRate, Scratch& buffers) const
+    {
+        SimpleCompressor compressor;
+        DynamicsStatistics statistics;
+        ScopedNoDenormals noDenormals;  // per thread, so set on each pool thread
+
+        auto makeupGain = candidate.settings.makeupGain;
+        auto replayGain = &loudnessSource != &source;
+
+        compressor.prepareToPlay(sampleRate);
+        compressor.setParametersWithRatioPreset(candidate.settings.threshold, candidate.ratioPreset, candidate.settings.attack,
+                                                candidate.settings.release, makeupGain);
+        compressor.setStatistics(&statistics);
+
+        if (replayGain)
+            compressor.setGainReductionTap(&buffers.gainReduction);
+
+        MetricsMeter meter(sampleRate);
+        auto numChannels = source.getNumChannels();
+        auto blockSize = buffers.block.getNumSamples();
+
+        for (int start = 0; start < source.getNumSamples(); start += blockSize)
+        {
+            auto numSamples = jmin(blockSize, source.getNumSamples() - start);
+            AudioBuffer<float> block(buffers.block.getArrayOfWritePointers(), numChannels, 0, numSamples);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                block.copyFrom(channel, 0, source, channel, start, numSamples);
+
+            compressor.processBuffer(block);
+
+            if (! replayGain)
+            {
+                meter.addBlock(block);
+                continue;
+            }
+
+            meter.addPeak(block);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* dest = block.getWritePointer(channel);
+                auto* input = loudnessSource.getReadPointer(channel, start);
+                auto* reduction = buffers.gainReduction.getReadPointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    dest[i] = input[i] * Decibels::decibelsToGain(makeupGain - reduction[i]);
+            }
+
+            meter.addEnergy(block);
+        }
+
+        auto maxGainReduction = 0.0f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            maxGainReduction = jmax(maxGainReduction, statistics.getChannelSnapshot(channel).peakGainReduction);
+
+        candidate.metrics = meter.getMetrics(maxGainReduction);
+        candidate.cost = costOf(candidate.metrics);
+    }
+
+    double costOf(const Metrics& metrics) const
+    {
+        return targets.loudnessRangeWeight * std::abs(metrics.loudnessRange - targets.loudnessRange)
+             + targets.peakToLoudnessRatioWeight * std::abs(metrics.peakToLoudnessRatio - targets.peakToLoudnessRatio)
+             + targets.maxGainReductionWeight * jmax(0.0f, metrics.maxGainReduction - targets.maxGainReduction);
+    }
+
+    /** Peak-preserving decimation, for the detector: keep the largest-magnitude sample of each group */
+    static AudioBuffer<float> createPeakProxy(const AudioBuffer<float>& audio, int decimation)
+    {
+        auto numProxySamples = jmax(1, audio.getNumSamples() / decimation);
+        AudioBuffer<float> proxy(audio.getNumChannels(), numProxySamples);
+
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        {
+            auto* source = audio.getReadPointer(channel);
+            auto* dest = proxy.getWritePointer(channel);
+
+            for (int i = 0; i < numProxySamples; ++i)
+            {
+                auto start = i * decimation;
+                auto end = jmin(start + decimation, audio.getNumSamples());
+                auto largest = 0.0f;
+
+                for (int j = start; j < end; ++j)
+                    if (std::abs(source[j]) > std::abs(largest))
+                        largest = source[j];
+
+                dest[i] = largest;
+            }
+        }
+
+        return proxy;
+    }
+
+    /** Energy-preserving decimation, for loudness: the RMS of each group. A low-pass
+        before decimating would drop the energy above the proxy's Nyquist frequency,
+        which the unweighted loudness figures count.
+    */
+    static AudioBuffer<float> createRMSProxy(const AudioBuffer<float>& audio, int decimation)
+    {
+        auto numProxySamples = jmax(1, audio.getNumSamples() / decimation);
+        AudioBuffer<float> proxy(audio.getNumChannels(), numProxySamples);
+
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        {
+            auto* source = audio.getReadPointer(channel);
+            auto* dest = proxy.getWritePointer(channel);
+
+            for (int i = 0; i < numProxySamples; ++i)
+            {
+                auto start = i * decimation;
+                auto end = jmin(start + decimation, audio.getNumSamples());
+                auto energy = 0.0;
+
+                for (int j = start; j < end; ++j)
+                    energy += (double) source[j] * source[j];
+
+                dest[i] = end > start ? static_cast<float>(std::sqrt(energy / (end - start))) : 0.0f;
+            }
+        }
+
+        return proxy;
+    }
+
+    //==============================================================================
+    static double powerToDb(double power)  { return 10.0 * std::log10(jmax(power, 1e-20)); }
+
+    /** Power mean of the blocks above the absolute gate, in dB */
+    static double gatedMean(const std::vector<double>& powers, double gateDb)
+    {
+        auto sum = 0.0;
+        auto count = 0;
+
+        for (auto power : powers)
+        {
+            if (powerToDb(power) > gateDb)
+            {
+                sum += power;
+                ++count;
+            }
+        }
+
+        return count > 0 ? powerToDb(sum / count) : -70.0;
+    }
+
+    //==============================================================================
+    Targets targets;
+    Options options;
+    ThreadPool pool;
+    std::vector<Scratch> scratch;   // one per pool worker
+    AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterAutoTuner)
+};
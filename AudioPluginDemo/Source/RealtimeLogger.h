@@ -0,0 +1,342 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <array>
+
+//==============================================================================
+/** Wait-free logging from the audio thread.
+
+    Log points write a fixed-size binary LogRecord into a per-instance
+    RealtimeLogRing (a single-producer AbstractFifo, no locks, no allocation).
+    A shared RealtimeLogWriter thread drains every registered ring, formats the
+    records and appends them to a log file, with a per-event rate limit so a
+    fallback that fires every sample can't flood the disk.
+
+    Log points are compiled in through COMPRESSOR_RT_LOG. Events masked out of
+    COMPRESSOR_RT_LOG_EVENT_MASK, or all of them when COMPRESSOR_RT_LOGGING is 0,
+    compile to nothing, so a disabled log point has no cost at all.
+*/
+
+#ifndef COMPRESSOR_RT_LOGGING
+ #define COMPRESSOR_RT_LOGGING 1
+#endif
+
+#ifndef COMPRESSOR_RT_LOG_EVENT_MASK
+ #define COMPRESSOR_RT_LOG_EVENT_MASK 0xffffffffu
+#endif
+
+//==============================================================================
+/** Everything the DSP can report. Keep getRealtimeLogEventName() in sync. */
+enum class RealtimeLogEvent : uint16
+{
+    nonFiniteInput,         // NaN/inf input replaced by silence
+    nonFiniteGain,          // gain computation fell back to unity
+    nonFiniteOutput,        // output replaced by silence
+    softLimitEngaged,       // soft limiter started limiting
+    extremeAttack,          // Compressor: stabilised attack for extreme settings
+    extremeRelease,         // Compressor: stabilised release for extreme settings
+    fastAttackSmoothing,    // Compressor: smoothed attack below 2 ms
+    extremeSaturation,      // Compressor: extreme saturation stage engaged
+    numEvents
+};
+
+inline const char* getRealtimeLogEventName(RealtimeLogEvent event)
+{
+    switch (event)
+    {
+        case RealtimeLogEvent::nonFiniteInput:       return "nonFiniteInput";
+        case RealtimeLogEvent::nonFiniteGain:        return "nonFiniteGain";
+        case RealtimeLogEvent::nonFiniteOutput:      return "nonFiniteOutput";
+        case RealtimeLogEvent::softLimitEngaged:     return "softLimitEngaged";
+        case RealtimeLogEvent::extremeAttack:        return "extremeAttack";
+        case RealtimeLogEvent::extremeRelease:       return "extremeRelease";
+        case RealtimeLogEvent::fastAttackSmoothing:  return "fastAttackSmoothing";
+        case RealtimeLogEvent::extremeSaturation:    return "extremeSaturation";
+        case RealtimeLogEvent::numEvents:            break;
+    }
+
+    return "unknown";
+}
+
+/** True if a log point for this event is compiled in */
+constexpr bool isRealtimeLogEventEnabled(RealtimeLogEvent event)
+{
+    return COMPRESSOR_RT_LOGGING != 0
+        && ((COMPRESSOR_RT_LOG_EVENT_MASK >> static_cast<uint32>(event)) & 1u) != 0;
+}
+
+//==============================================================================
+/** One fixed-size binary log record */
+struct LogRecord
+{
+    RealtimeLogEvent event = RealtimeLogEvent::nonFiniteInput;
+    uint16 channel = 0;
+    int64 samplePosition = 0;
+    float values[3] = {};
+};
+
+//==============================================================================
+/** Per-instance single-producer/single-consumer ring of log records.
+    push() is wait-free and is the only method the audio thread may call.
+*/
+class RealtimeLogRing
+{
+public:
+    //==============================================================================
+    RealtimeLogRing(const String& instanceName, int capacity = 1024)
+        : name(instanceName), fifo(capacity), records((size_t) capacity)
+    {
+    }
+
+    /** Audio thread: append a record, or count it as dropped if the ring is full */
+    void push(RealtimeLogEvent event, int channel, int64 samplePosition,
+              float value0 = 0.0f, float value1 = 0.0f, float value2 = 0.0f) noexcept
+    {
+        const auto scope = fifo.write(1);
+        auto index = scope.blockSize1 > 0 ? scope.startIndex1 : (scope.blockSize2 > 0 ? scope.startIndex2 : -1);
+
+        if (index < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto& record = records[(size_t) index];
+        record.event = event;
+        record.channel = static_cast<uint16>(channel);
+        record.samplePosition = samplePosition;
+        record.values[0] = value0;
+        record.values[1] = value1;
+        record.values[2] = value2;
+    }
+
+    /** Writer thread: move up to maxRecords records into dest */
+    int pop(LogRecord* dest, int maxRecords)
+    {
+        const ScopedLock sl(storageLock);
+        const auto scope = fifo.read(maxRecords);
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = records[(size_t) (scope.startIndex1 + i)];
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = records[(size_t) (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    /** Writer thread: records lost to a full ring since the last call */
+    uint32 takeDroppedCount()   { return dropped.exchange(0); }
+
+    const String& getName() const { return name; }
+
+    //==============================================================================
+    /** Background thread: free the record storage while nobody pushes to this ring.
+        Returns false, leaving the storage alone, while records are still waiting
+        to be written.
+    */
+    bool releaseStorage()
+    {
+        const ScopedLock sl(storageLock);
+
+        if (fifo.getNumReady() > 0)
+            return false;
+
+        std::vector<LogRecord>().swap(records);
+        return true;
+    }
+
+    /** Background thread: re-allocate storage freed by releaseStorage() */
+    bool reserveStorage()
+    {
+        const ScopedLock sl(storageLock);
+        records.resize((size_t) fifo.getTotalSize());
+        fifo.reset();
+        return true;
+    }
+
+private:
+    //==============================================================================
+    String name;
+    AbstractFifo fifo;
+    std::vector<LogRecord> records;
+    CriticalSection storageLock;        // never taken by push()
+    std::atomic<uint32> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeLogRing)
+};
+
+//==============================================================================
+/** Background thread that formats records from all registered rings into a log file.
+    Share one instance per process with SharedResourcePointer<RealtimeLogWriter>.
+*/
+class RealtimeLogWriter : private Thread
+{
+public:
+    //==============================================================================
+    RealtimeLogWriter()
+        : Thread("Realtime log writer"),
+          logFile(File::getSpecialLocation(File::tempDirectory).getChildFile("CompressorRealtime.log"))
+    {
+        startThread(Priority::low);
+    }
+
+    ~RealtimeLogWriter() override
+    {
+        stopThread(2000);
+    }
+
+    /** Message thread: start draining a ring. The ring must stay alive until removed. */
+    void addRing(RealtimeLogRing* ring)
+    {
+        const ScopedLock sl(lock);
+        if (rings.addIfNotAlreadyThere(ring))
+            rateLimits.add(RateLimit());
+    }
+
+    /** Message thread: stop draining a ring, after writing whatever is left in it */
+    void removeRing(RealtimeLogRing* ring)
+    {
+        const ScopedLock sl(lock);
+        auto index = rings.indexOf(ring);
+
+        if (index >= 0)
+        {
+            drainRing(index);
+            rings.remove(index);
+            rateLimits.remove(index);
+        }
+    }
+
+    void setLogFile(const File& newLogFile)
+    {
+        const ScopedLock sl(lock);
+        logFile = newLogFile;
+        stream = nullptr;
+    }
+
+    /** Records per event, per ring, per second that reach the file; the rest are counted */
+    void setMaxRecordsPerSecond(int newMax)   { maxRecordsPerSecond.store(jmax(1, newMax)); }
+
+private:
+    //==============================================================================
+    struct RateLimit
+    {
+        std::array<double, (size_t) RealtimeLogEvent::numEvents> windowStart {};
+        std::array<int, (size_t) RealtimeLogEvent::numEvents> writtenInWindow {};
+        std::array<int, (size_t) RealtimeLogEvent::numEvents> suppressed {};
+    };
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const ScopedLock sl(lock);
+
+                for (int i = 0; i < rings.size(); ++i)
+                    drainRing(i);
+
+                if (stream != nullptr)
+                    stream->flush();
+            }
+
+            wait(50);
+        }
+    }
+
+    void drainRing(int ringIndex)
+    {
+        auto* ring = rings.getUnchecked(ringIndex);
+        auto& limit = rateLimits.getReference(ringIndex);
+        auto now = Time::getMillisecondCounterHiRes() * 0.001;
+        LogRecord batch[64];
+
+        if (auto dropped = ring->takeDroppedCount())
+            writeLine(ring->getName() + " ring full, " + String(dropped) + " records dropped");
+
+        for (;;)
+        {
+            auto numRead = ring->pop(batch, numElementsInArray(batch));
+
+            if (numRead == 0)
+                break;
+
+            for (int i = 0; i < numRead; ++i)
+            {
+                auto& record = batch[i];
+                auto eventIndex = (size_t) record.event;
+
+                if (eventIndex >= (size_t) RealtimeLogEvent::numEvents)
+                    continue;
+
+                if (now - limit.windowStart[eventIndex] >= 1.0)
+                {
+                    limit.windowStart[eventIndex] = now;
+                    limit.writtenInWindow[eventIndex] = 0;
+                }
+
+                if (limit.writtenInWindow[eventIndex] >= maxRecordsPerSecond.load())
+                {
+                    ++limit.suppressed[eventIndex];
+                    continue;
+                }
+
+                ++limit.writtenInWindow[eventIndex];
+
+                String line;
+                line << ring->getName() << " " << getRealtimeLogEventName(record.event)
+                     << " ch " << (int) record.channel
+                     << " @ " << record.samplePosition
+                     << " [" << record.values[0] << ", " << record.values[1] << ", " << record.values[2] << "]";
+
+                if (limit.suppressed[eventIndex] > 0)
+                {
+                    line << " (" << limit.suppressed[eventIndex] << " suppressed)";
+                    limit.suppressed[eventIndex] = 0;
+                }
+
+                writeLine(line);
+            }
+        }
+    }
+
+    void writeLine(const String& line)
+    {
+        if (stream == nullptr)
+        {
+            stream = std::make_unique<FileOutputStream>(logFile);
+
+            if (stream->failedToOpen())
+            {
+                stream = nullptr;
+                return;
+            }
+        }
+
+        *stream << Time::getCurrentTime().toISO8601(true) << " " << line << newLine;
+    }
+
+    //==============================================================================
+    CriticalSection lock;
+    Array<RealtimeLogRing*> rings;
+    Array<RateLimit> rateLimits;
+    File logFile;
+    std::unique_ptr<FileOutputStream> stream;
+    std::atomic<int> maxRecordsPerSecond { 10 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeLogWriter)
+};
+
+//==============================================================================
+/** Log point. Compiles to nothing unless the event is enabled, and does nothing
+    at run time unless a ring is attached. Pass at least one value after the
+    sample position: the macro is plain C++17, without the GNU ## extension.
+*/
+#define COMPRESSOR_RT_LOG(ring, event, channel, samplePosition, ...) \
+    do { \
+        if constexpr (isRealtimeLogEventEnabled(event)) \
+            if ((ring) != nullptr) \
+                (ring)->push(event, channel, samplePosition, __VA_ARGS__); \
+    } while (false)
@@ -4,6 +4,11 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <cmath>
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include "DynamicsStatistics.h"
+#include "RealtimeLogger.h"
 
 //==============================================================================
 /** A simple, classic compressor design without complex logic.
@@ -31,17 +36,255 @@ public:
     void reset()
     {
         envelope = 0.0f;
+        softLimiting.fill(false);
+        overloading.fill(false);
+        appliedReduction = 0.0f;
+        limiterReduction = 0.0f;
+        blockStartPosition = 0;
     }
     
     /** Process a single sample through the compressor */
     float processSample(float input)
     {
+        auto sampleIndex = blockSummary.numSamples;
+        auto gainReduction = detectGainReduction(input);
+        
+        if (gainReduction < 0.0f)
+            return 0.0f;
+        
+        advanceEnvelope(gainReduction);
+        return applyGain(input, envelope, sampleIndex);
+    }
+    
+    /** Process a buffer of samples */
+    template<typename FloatType>
+    void processBuffer(juce::AudioBuffer<FloatType>& buffer)
+    {
+        auto numSamples = buffer.getNumSamples();
+        auto numChannels = buffer.getNumChannels();
+        inputPeak = 0.0f;
+        
+        for (auto channel = 0; channel < numChannels; ++channel)
+        {
+            auto channelData = buffer.getWritePointer(channel);
+            blockSummary = {};
+            currentChannel = channel;
+            tapData = getTapPointer(channel);
+            
+            (this->*getKernel<FloatType>())(channelData, numSamples);
+            
+            if (statistics != nullptr)
+                statistics->addChannelBlock(channel, blockSummary);
+        }
+        
+        if (statistics != nullptr)
+            statistics->advance(numSamples);
+        
+        blockStartPosition += numSamples;
+    }
+    
+    /** Passthrough for a hibernating instance: silent input with a settled envelope.
+        
+        For input this quiet the full path reduces to the makeup gain, so that is
+        all this applies (nothing at 0 dB). The QC statistics and sample position
+        still advance, so the programme report covers the hibernated stretch.
+        
+        A block with NaN or infinite samples isn't silent: it goes through
+        processBuffer(), which replaces them and logs it.
+    */
+    template<typename FloatType>
+    void processHibernatedBuffer(juce::AudioBuffer<FloatType>& buffer)
+    {
+        if (! std::isfinite(getFinitePeak(buffer)))
+        {
+            processBuffer(buffer);
+            return;
+        }
+        
+        auto numSamples = buffer.getNumSamples();
+        envelope = 0.0f;
+        softLimiting.fill(false);
+        overloading.fill(false);
+        
+        if (! juce::exactlyEqual(makeupGain, 0.0f))
+            buffer.applyGain(static_cast<FloatType>(getMakeupGainLinear()));
+        
+        for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+            if (auto* tap = getTapPointer(channel))
+                std::fill(tap, tap + numSamples, getMakeupLimitReduction());
+        
+        if (statistics != nullptr)
+        {
+            blockSummary = {};
+            blockSummary.numSamples = numSamples;
+            blockSummary.addToHistogram(0.0f, numSamples);
+            
+            for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+                statistics->addChannelBlock(channel, blockSummary);
+            
+            statistics->advance(numSamples);
+        }
+        
+        blockStartPosition += numSamples;
+    }
+    
+    /** Peak magnitude over all channels, or infinity if any sample is NaN or
+        infinite. For silence checks: a NaN fails every comparison, and a magnitude
+        scan can skip it, so either way it could pass as silence.
+    */
+    template<typename FloatType>
+    static float getFinitePeak(const juce::AudioBuffer<FloatType>& buffer)
+    {
+        auto peak = 0.0f;
+        
+        for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getReadPointer(channel);
+            
+            for (auto i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                if (!std::isfinite(data[i]))
+                    return std::numeric_limits<float>::infinity();
+                
+                peak = std::max(peak, static_cast<float>(std::abs(data[i])));
+            }
+        }
+        
+        return peak;
+    }
+    
+    /** True once the envelope has released to (practically) zero gain reduction */
+    bool isSettled() const { return envelope < settledEnvelope; }
+    
+    /** Peak magnitude of the finite input to the last processBuffer() call, over
+        all channels, as measured by the detector
+    */
+    float getLastInputPeak() const { return inputPeak; }
+    
+    //==============================================================================
+    /** Attach QC statistics that processBuffer() feeds once per channel per block.
+        Pass nullptr to detach. The statistics object must outlive the compressor.
+    */
+    void setStatistics(DynamicsStatistics* newStatistics) { statistics = newStatistics; }
+    
+    /** Summary of the most recently processed channel block */
+    const DynamicsStatistics::BlockSummary& getLastBlockSummary() const { return blockSummary; }
+    
+    /** Record the gain reduction applied to every sample, in dB, into tap: one
+        channel per processed channel, with room for the largest buffer.
+        
+        This is the gain actually applied, relative to the makeup gain: the
+        envelope after the gain limits, plus whatever the soft limiter took off.
+        The output is the input times 10^((makeup - tap) / 20). Non-finite input
+        samples, which are replaced with silence, repeat the previous value.
+        
+        Pass nullptr to stop. The tap must outlive the compressor.
+    */
+    void setGainReductionTap(juce::AudioBuffer<float>* newTap) { gainReductionTap = newTap; }
+    
+    /** Attach a realtime log ring for the safety fallbacks. Pass nullptr to detach.
+        The ring must outlive the compressor.
+    */
+    void setLogRing(RealtimeLogRing* newLogRing) { logRing = newLogRing; }
+    
+    //==============================================================================
+    /** The ratios offered by the plugin's ratio parameter */
+    static constexpr int numRatioPresets = 8;
+    static constexpr std::array<float, numRatioPresets> ratioPresets { 1.0f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 10.0f, 20.0f };
+    
+    /** Set compressor parameters. Any ratio runs the generic channel kernel. */
+    void setParameters(float newThreshold, float newRatio, float newAttack, 
+                      float newRelease, float newMakeupGain)
+    {
+        setLevelsAndTimes(newThreshold, newAttack, newRelease, newMakeupGain);
+        ratio = std::max(newRatio, 1.0f);
+        selectKernel(noRatioPreset);
+    }
+    
+    /** Set compressor parameters with the ratio given as an index into
+        ratioPresets, which runs a channel kernel specialised for that ratio
+    */
+    void setParametersWithRatioPreset(float newThreshold, int ratioPresetIndex, float newAttack,
+                                      float newRelease, float newMakeupGain)
+    {
+        setLevelsAndTimes(newThreshold, newAttack, newRelease, newMakeupGain);
+        setRatioPreset(ratioPresetIndex);
+    }
+    
+    void setThreshold(float newThreshold) { threshold = newThreshold; thresholdGain = powf(10.0f, threshold / 20.0f); }
+    void setRatio(float newRatio) { ratio = std::max(newRatio, 1.0f); selectKernel(noRatioPreset); }
+    void setRatioPreset(int presetIndex)
+    {
+        presetIndex = juce::jlimit(0, numRatioPresets - 1, presetIndex);
+        ratio = ratioPresets[(size_t) presetIndex];
+        selectKernel(presetIndex);
+    }
+    void setAttack(float newAttack) { attack = std::max(newAttack, 0.1f); updateCoefficients(); }
+    void setRelease(float newRelease) { release = std::max(newRelease, 1.0f); updateCoefficients(); }
+    void setMakeupGain(float newMakeupGain) { makeupGain = newMakeupGain; }
+    
+    //==============================================================================
+    /** Get current parameter values */
+    float getThreshold() const { return threshold; }
+    float getRatio() const { return ratio; }
+    float getAttack() const { return attack; }
+    float getRelease() const { return release; }
+    float getMakeupGain() const { return makeupGain; }
+    float getCurrentGainReduction() const { return -envelope; }
+    float getCurrentEnvelope() const { return envelope; }
+    float getCurrentInputLevel() const { return 0.0f; }  // Simple version doesn't track this
+    float getCurrentOutputLevel() const { return 0.0f; } // Simple version doesn't track this
+    
+private:
+    //==============================================================================
+    // Samples per detector/envelope pass in processBuffer()
+    static constexpr int envelopeChunkSize = 64;
+    
+    // Kernel template argument for ratios that aren't one of the presets
+    static constexpr int genericRatio = 0;
+    static constexpr int noRatioPreset = -1;
+    
+    /** Detector: gain reduction the envelope is heading for, in dB.
+        Returns -1 for a non-finite input, which is replaced by silence.
+        
+        Ratio is one of the plugin's presets, making the slope 1 - 1/ratio a
+        compile-time constant, or genericRatio to use the ratio parameter.
+    */
+    template<int Ratio = genericRatio>
+    float detectGainReduction(float input)
+    {
+        auto sampleIndex = blockSummary.numSamples++;
+        
         // Safety check for invalid input
         if (!std::isfinite(input))
-            return 0.0f;
+        {
+            if (blockSummary.nonFiniteSamples++ == 0)
+                blockSummary.firstNonFiniteSample = sampleIndex;
+            
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteInput, currentChannel,
+                              blockStartPosition + sampleIndex, envelope);
+            return -1.0f;
+        }
         
         // Calculate input level in dB with safety limits
         auto absInput = std::abs(input);
+        inputPeak = std::max(inputPeak, absInput);
+        
+        if (absInput >= 1.0f)
+        {
+            ++blockSummary.overloadSamples;
+            blockSummary.overloadPeak = std::max(blockSummary.overloadPeak, absInput);
+            
+            if (!overloadState() && blockSummary.overloadOnsets++ == 0)
+                blockSummary.firstOverloadOnset = sampleIndex;
+            
+            overloadState() = true;
+        }
+        else
+        {
+            overloadState() = false;
+        }
+        
         absInput = std::max(absInput, 1e-10f);  // Prevent log of zero
         auto inputLevel = 20.0f * log10f(absInput);
         
@@ -52,14 +295,25 @@ public:
         auto gainReduction = 0.0f;
         if (inputLevel > threshold)
         {
+            ++blockSummary.samplesAboveThreshold;
+            
             auto overThreshold = inputLevel - threshold;
-            gainReduction = overThreshold - (overThreshold / ratio);
+            
+            if constexpr (Ratio == genericRatio)
+                gainReduction = overThreshold * slope;
+            else
+                gainReduction = overThreshold * (1.0f - 1.0f / static_cast<float>(Ratio));
             
             // Limit maximum gain reduction to prevent extreme compression
             gainReduction = std::min(gainReduction, 60.0f);
         }
         
-        // Apply attack/release envelope
+        return gainReduction;
+    }
+    
+    /** One step of the attack/release envelope recursion */
+    void advanceEnvelope(float gainReduction)
+    {
         if (gainReduction > envelope)
         {
             // Attack phase
@@ -71,91 +325,360 @@ public:
             envelope = envelope + releaseCoeff * (gainReduction - envelope);
         }
         
-        // Bounds check on envelope
+        // Bounds check on envelope, flushing a finished release tail to exactly zero
         envelope = std::max(0.0f, std::min(60.0f, envelope));
         
+        if (envelope < envelopeFloor)
+            envelope = 0.0f;
+    }
+    
+    /** Gain stage: apply an envelope value and makeup gain to one sample */
+    float applyGain(float input, float envelopeValue, int sampleIndex)
+    {
+        blockSummary.peakGainReduction = std::max(blockSummary.peakGainReduction, envelopeValue);
+        blockSummary.addToHistogram(envelopeValue);
+        
+        return limitOutput(input, getLinearGain(envelopeValue, sampleIndex), envelopeValue, sampleIndex);
+    }
+    
+    /** Gain stage for a run of samples that share one envelope value: the same
+        result as applyGain() on each sample, with the gain computed once
+    */
+    template<typename FloatType>
+    void applyConstantGain(FloatType* data, int numSamples, float envelopeValue, int firstSampleIndex)
+    {
+        blockSummary.peakGainReduction = std::max(blockSummary.peakGainReduction, envelopeValue);
+        blockSummary.addToHistogram(envelopeValue, numSamples);
+        
+        auto gain = getLinearGain(envelopeValue, firstSampleIndex);
+        
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            data[i] = static_cast<FloatType>(limitOutput(static_cast<float>(data[i]), gain, envelopeValue, firstSampleIndex + i));
+            
+            if (tapData != nullptr)
+                tapData[i] = appliedReduction + limiterReduction;
+        }
+        
+        if (tapData != nullptr)
+            tapData += numSamples;
+    }
+    
+    /** Linear gain for an envelope value, with the makeup gain and safety limits */
+    float getLinearGain(float envelopeValue, int sampleIndex)
+    {
         // Apply compression and makeup gain with safety limits
-        auto gainInDb = -envelope + makeupGain;
+        auto gainInDb = -envelopeValue + makeupGain;
         
         // Limit total gain to prevent clipping
         gainInDb = std::max(-60.0f, std::min(20.0f, gainInDb));
+        appliedReduction = makeupGain - gainInDb;
         
         auto compressedGain = powf(10.0f, gainInDb / 20.0f);
         
         // Final safety check on gain value
         if (!std::isfinite(compressedGain))
+        {
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteGain, currentChannel,
+                              blockStartPosition + sampleIndex, gainInDb, envelopeValue);
             compressedGain = 1.0f;
+            appliedReduction = makeupGain;
+        }
         
         // Limit gain to reasonable range
-        compressedGain = std::max(0.001f, std::min(10.0f, compressedGain));
-        
+        return std::max(0.001f, std::min(10.0f, compressedGain));
+    }
+    
+    /** Apply a linear gain to one sample, then the output safety check and soft limiter */
+    float limitOutput(float input, float compressedGain, float envelopeValue, int sampleIndex)
+    {
         auto output = input * compressedGain;
         
         // Final output safety check and soft limiting
         if (!std::isfinite(output))
+        {
+            COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::nonFiniteOutput, currentChannel,
+                              blockStartPosition + sampleIndex, input, compressedGain);
             return 0.0f;
+        }
         
         // Soft limiting to prevent hard clipping
         if (std::abs(output) > 0.95f)
         {
+            ++blockSummary.softLimitedSamples;
+            
+            if (!softLimitState())
+            {
+                ++blockSummary.softLimitOnsets;
+                COMPRESSOR_RT_LOG(logRing, RealtimeLogEvent::softLimitEngaged, currentChannel,
+                                  blockStartPosition + sampleIndex, output, envelopeValue);
+            }
+            
+            softLimitState() = true;
+            
             // Simple tanh soft limiting
-            output = std::tanh(output * 0.8f) * 0.95f;
+            auto limited = std::tanh(output * 0.8f) * 0.95f;
+            
+            if (tapData != nullptr)
+                limiterReduction = 20.0f * log10f(output / limited);
+            
+            output = limited;
+        }
+        else
+        {
+            softLimitState() = false;
+            limiterReduction = 0.0f;
         }
         
         return output;
     }
     
-    /** Process a buffer of samples */
-    template<typename FloatType>
-    void processBuffer(juce::AudioBuffer<FloatType>& buffer)
+    /** Process up to envelopeChunkSize samples of one channel.
+        
+        Runs the detector over the whole chunk first. If every sample has the same
+        target (all zero in a release tail, or one level in a sustained overload)
+        the recursion env += coeff * (target - env) has the closed form
+        env[k] = target + (env0 - target) * (1 - coeff)^(k + 1), which is computed
+        from the precomputed power tables in a loop the compiler vectorises.
+        Once the envelope has settled on that target (below threshold, or a
+        steady overload), the gain is the same for the whole chunk and is
+        computed once rather than per sample.
+        Mixed chunks fall back to the sample-by-sample recursion.
+    */
+    template<int Ratio, typename FloatType>
+    void processChunk(FloatType* data, int numSamples)
     {
-        auto numSamples = buffer.getNumSamples();
-        auto numChannels = buffer.getNumChannels();
+        jassert (numSamples > 0 && numSamples <= envelopeChunkSize);
         
-        for (auto channel = 0; channel < numChannels; ++channel)
+        if (numSamples <= 0)
+            return;
+        
+        if constexpr (Ratio == 1)
         {
-            auto channelData = buffer.getWritePointer(channel);
+            if (juce::exactlyEqual(envelope, 0.0f) && processBypassChunk(data, numSamples))
+            {
+                if (tapData != nullptr)
+                {
+                    std::fill(tapData, tapData + numSamples, getMakeupLimitReduction());
+                    tapData += numSamples;
+                }
+                
+                return;
+            }
+        }
+        
+        float targets[envelopeChunkSize];
+        float envelopes[envelopeChunkSize];
+        auto firstSampleIndex = blockSummary.numSamples;
+        
+        for (auto i = 0; i < numSamples; ++i)
+            targets[i] = detectGainReduction<Ratio>(static_cast<float>(data[i]));
+        
+        auto target = targets[0];
+        auto constantTarget = target >= 0.0f;
+        
+        for (auto i = 1; i < numSamples; ++i)
+            constantTarget &= juce::exactlyEqual(targets[i], target);
+        
+        if (constantTarget)
+        {
+            // Attack and release coefficients pick the same branch for the whole chunk
+            auto* powers = target > envelope ? attackPowers.data() : releasePowers.data();
+            auto offset = envelope - target;
             
-            for (auto sample = 0; sample < numSamples; ++sample)
+            for (auto i = 0; i < numSamples; ++i)
+                envelopes[i] = target + offset * powers[i];
+            
+            envelope = envelopes[numSamples - 1];
+            
+            if (envelope < envelopeFloor)
+                envelope = 0.0f;
+            
+            // The sequence is monotonic, so equal ends mean a constant envelope
+            if (juce::exactlyEqual(envelopes[0], envelopes[numSamples - 1]))
             {
-                channelData[sample] = processSample(static_cast<float>(channelData[sample]));
+                applyConstantGain(data, numSamples, envelopes[0], firstSampleIndex);
+                return;
             }
         }
+        else
+        {
+            for (auto i = 0; i < numSamples; ++i)
+            {
+                if (targets[i] < 0.0f)
+                {
+                    envelopes[i] = -1.0f;  // non-finite input, envelope holds
+                    continue;
+                }
+                
+                advanceEnvelope(targets[i]);
+                envelopes[i] = envelope;
+            }
+        }
+        
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            data[i] = envelopes[i] < 0.0f
+                        ? FloatType(0)
+                        : static_cast<FloatType>(applyGain(static_cast<float>(data[i]), envelopes[i], firstSampleIndex + i));
+            
+            if (tapData != nullptr)
+                tapData[i] = appliedReduction + limiterReduction;
+        }
+        
+        if (tapData != nullptr)
+            tapData += numSamples;
+    }
+    
+    /** 1:1 with a settled envelope: the detector, log and envelope can't change
+        anything, so the whole chunk is one makeup gain multiply.
+        
+        Only taken when the chunk needs none of the per-sample safety paths: all
+        input finite and below full scale, and no output reaching the soft
+        limiter. Returns false otherwise, leaving the chunk to the full path.
+    */
+    template<typename FloatType>
+    bool processBypassChunk(FloatType* data, int numSamples)
+    {
+        auto peak = 0.0f;
+        auto allFinite = true;
+        
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            auto input = static_cast<float>(data[i]);
+            peak = std::max(peak, std::abs(input));
+            allFinite &= std::isfinite(input);
+        }
+        
+        auto gain = getMakeupGainLinear();
+        
+        if (! allFinite || peak >= 1.0f || peak * gain > 0.95f)
+            return false;
+        
+        auto aboveThreshold = 0;
+        
+        for (auto i = 0; i < numSamples; ++i)
+        {
+            aboveThreshold += std::abs(static_cast<float>(data[i])) > thresholdGain ? 1 : 0;
+            data[i] *= static_cast<FloatType>(gain);
+        }
+        
+        inputPeak = std::max(inputPeak, peak);
+        blockSummary.numSamples += numSamples;
+        blockSummary.samplesAboveThreshold += aboveThreshold;
+        blockSummary.addToHistogram(0.0f, numSamples);
+        softLimitState() = false;
+        overloadState() = false;
+        return true;
+    }
+    
+    /** One channel of processBuffer(), in envelope chunks */
+    template<int Ratio, typename FloatType>
+    void processChannel(FloatType* data, int numSamples)
+    {
+        for (auto start = 0; start < numSamples; start += envelopeChunkSize)
+        {
+            processChunk<Ratio>(data + start, std::min(envelopeChunkSize, numSamples - start));
+        }
     }
     
     //==============================================================================
-    /** Set compressor parameters */
-    void setParameters(float newThreshold, float newRatio, float newAttack, 
-                      float newRelease, float newMakeupGain)
+    template<typename FloatType>
+    using Kernel = void (SimpleCompressor::*)(FloatType*, int);
+    
+    template<typename FloatType>
+    Kernel<FloatType> getKernel() const
+    {
+        if constexpr (std::is_same_v<FloatType, double>)
+            return doubleKernel;
+        else
+            return floatKernel;
+    }
+    
+    template<int PresetIndex>
+    void setKernels()
+    {
+        static constexpr auto presetRatio = static_cast<int>(ratioPresets[(size_t) PresetIndex]);
+        
+        floatKernel = &SimpleCompressor::processChannel<presetRatio, float>;
+        doubleKernel = &SimpleCompressor::processChannel<presetRatio, double>;
+    }
+    
+    /** Pick the channel kernel for a ratio preset index, or the generic kernel
+        for noRatioPreset. Only swaps kernels when the preset has changed, so it
+        is cheap to call from every setParameters().
+    */
+    void selectKernel(int presetIndex)
+    {
+        slope = 1.0f - 1.0f / ratio;
+        
+        if (presetIndex == kernelPreset)
+            return;
+        
+        kernelPreset = presetIndex;
+        
+        switch (presetIndex)
+        {
+            case 0:  setKernels<0>(); break;
+            case 1:  setKernels<1>(); break;
+            case 2:  setKernels<2>(); break;
+            case 3:  setKernels<3>(); break;
+            case 4:  setKernels<4>(); break;
+            case 5:  setKernels<5>(); break;
+            case 6:  setKernels<6>(); break;
+            case 7:  setKernels<7>(); break;
+            default:
+                floatKernel = &SimpleCompressor::processChannel<genericRatio, float>;
+                doubleKernel = &SimpleCompressor::processChannel<genericRatio, double>;
+                break;
+        }
+    }
+    
+    /** Threshold, attack, release and makeup: everything but the ratio */
+    void setLevelsAndTimes(float newThreshold, float newAttack, float newRelease, float newMakeupGain)
     {
         threshold = newThreshold;
-        ratio = std::max(newRatio, 1.0f);
         attack = std::max(newAttack, 0.1f);    // Minimum 0.1ms to prevent instability
         release = std::max(newRelease, 1.0f);  // Minimum 1.0ms to prevent instability
         makeupGain = newMakeupGain;
+        thresholdGain = powf(10.0f, threshold / 20.0f);
         
         updateCoefficients();
     }
     
-    void setThreshold(float newThreshold) { threshold = newThreshold; }
-    void setRatio(float newRatio) { ratio = std::max(newRatio, 1.0f); updateCoefficients(); }
-    void setAttack(float newAttack) { attack = std::max(newAttack, 0.1f); updateCoefficients(); }
-    void setRelease(float newRelease) { release = std::max(newRelease, 1.0f); updateCoefficients(); }
-    void setMakeupGain(float newMakeupGain) { makeupGain = newMakeupGain; }
+    /** Soft limiter and overload state of the channel being processed. Channels
+        past DynamicsStatistics::maxChannels share the last flag.
+    */
+    bool& softLimitState()
+    {
+        return softLimiting[(size_t) std::min(currentChannel, DynamicsStatistics::maxChannels - 1)];
+    }
     
-    //==============================================================================
-    /** Get current parameter values */
-    float getThreshold() const { return threshold; }
-    float getRatio() const { return ratio; }
-    float getAttack() const { return attack; }
-    float getRelease() const { return release; }
-    float getMakeupGain() const { return makeupGain; }
-    float getCurrentGainReduction() const { return -envelope; }
-    float getCurrentEnvelope() const { return envelope; }
-    float getCurrentInputLevel() const { return 0.0f; }  // Simple version doesn't track this
-    float getCurrentOutputLevel() const { return 0.0f; } // Simple version doesn't track this
+    bool& overloadState()
+    {
+        return overloading[(size_t) std::min(currentChannel, DynamicsStatistics::maxChannels - 1)];
+    }
+    
+    float* getTapPointer(int channel) const
+    {
+        return gainReductionTap != nullptr && channel < gainReductionTap->getNumChannels()
+                 ? gainReductionTap->getWritePointer(channel)
+                 : nullptr;
+    }
+    
+    /** Gain reduction the gain limits alone take off the makeup gain, in dB */
+    float getMakeupLimitReduction() const
+    {
+        return makeupGain - std::max(-60.0f, std::min(20.0f, makeupGain));
+    }
+    
+    /** Linear gain of the gain stage with no gain reduction */
+    float getMakeupGainLinear() const
+    {
+        auto gainInDb = std::max(-60.0f, std::min(20.0f, makeupGain));
+        return std::max(0.001f, std::min(10.0f, powf(10.0f, gainInDb / 20.0f)));
+    }
     
-private:
     //==============================================================================
     /** Update attack/release coefficients */
     void updateCoefficients()
@@ -167,8 +690,33 @@ private:
             auto releaseSamples = release * 0.001f * static_cast<float>(sampleRate);
             
             // Standard exponential coefficient formula
-            attackCoeff = 1.0f - expf(-1.0f / attackSamples);
-            releaseCoeff = 1.0f - expf(-1.0f / releaseSamples);
+            auto newAttackCoeff = 1.0f - expf(-1.0f / attackSamples);
+            auto newReleaseCoeff = 1.0f - expf(-1.0f / releaseSamples);
+            
+            if (! juce::exactlyEqual(newAttackCoeff, attackCoeff))
+            {
+                attackCoeff = newAttackCoeff;
+                fillPowers(attackPowers, attackCoeff);
+            }
+            
+            if (! juce::exactlyEqual(newReleaseCoeff, releaseCoeff))
+            {
+                releaseCoeff = newReleaseCoeff;
+                fillPowers(releasePowers, releaseCoeff);
+            }
+        }
+    }
+    
+    /** powers[k] = (1 - coeff)^(k + 1), for the closed-form envelope */
+    static void fillPowers(std::array<float, envelopeChunkSize>& powers, float coeff)
+    {
+        auto decay = 1.0 - static_cast<double>(coeff);
+        auto power = 1.0;
+        
+        for (auto& p : powers)
+        {
+            power *= decay;
+            p = static_cast<float>(power);
         }
     }
     
@@ -181,12 +729,41 @@ private:
     float makeupGain = 0.0f;      // dB
     
     // Coefficients
+    float thresholdGain = 0.1f;   // threshold as a linear level
+    float slope = 0.75f;          // 1 - 1/ratio
     float attackCoeff = 0.0f;
     float releaseCoeff = 0.0f;
+    std::array<float, envelopeChunkSize> attackPowers {};
+    std::array<float, envelopeChunkSize> releasePowers {};
     
     // State
+    static constexpr float settledEnvelope = 1.0e-3f;  // dB
+    static constexpr float envelopeFloor = 1.0e-9f;    // dB, flushed to zero long before denormals
     float envelope = 0.0f;
     double sampleRate = 44100.0;
+    std::array<bool, DynamicsStatistics::maxChannels> softLimiting {};  // per channel, so each onset counts once
+    std::array<bool, DynamicsStatistics::maxChannels> overloading {};   // likewise for input overloads
+    float inputPeak = 0.0f;       // of the last processBuffer(), for idle detection
+    
+    // Channel kernel specialised for the current ratio preset (4:1 to start)
+    int kernelPreset = 3;
+    Kernel<float> floatKernel = &SimpleCompressor::processChannel<4, float>;
+    Kernel<double> doubleKernel = &SimpleCompressor::processChannel<4, double>;
+    
+    // QC statistics
+    DynamicsStatistics::BlockSummary blockSummary;
+    DynamicsStatistics* statistics = nullptr;
+    
+    // Per-sample gain reduction output, for envelope export
+    juce::AudioBuffer<float>* gainReductionTap = nullptr;
+    float* tapData = nullptr;
+    float appliedReduction = 0.0f;  // dB, from the last gain computed
+    float limiterReduction = 0.0f;  // dB, the soft limiter's share on the last sample
+    
+    // Realtime logging
+    RealtimeLogRing* logRing = nullptr;
+    int currentChannel = 0;
+    int64 blockStartPosition = 0;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimpleCompressor)
 };
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <vector>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/** Renders one file as three overlapping stages: decode, DSP and encode.
+
+    FLAC and other compressed codecs can cost more than the compressor. Run in
+    series on one thread, a file takes decode + DSP + encode. Here the stages run
+    concurrently, so a file takes roughly as long as its slowest stage.
+
+    - The DSP runs on the calling thread, e.g. a BatchRenderer worker.
+    - Decoding and encoding run as jobs on a codec ThreadPool. It is shared by
+      every pipeline on a NUMA node (see BatchRenderer), so codec work spreads
+      over whatever cores on the node are idle.
+    - The stages pass a fixed pool of preallocated blocks around through three
+      single-producer/single-consumer AbstractFifo queues of block indices:
+      free -> decoder -> decoded -> DSP -> processed -> encoder -> free.
+      The queues never lock and nothing is allocated per block.
+
+    Codec jobs work in short slices and hand their pool thread back whenever
+    they would have to wait. That way a batch never deadlocks with every pool
+    thread waiting on a stage that has no thread to run on.
+*/
+class StreamingRenderPipeline
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        int numBlocks = 8;          // blocks in flight between the stages
+        int blocksPerSlice = 4;     // blocks a codec job handles before yielding its thread
+    };
+
+    //==============================================================================
+    StreamingRenderPipeline(OfflineRenderer& rendererToUse, ThreadPool& codecPoolToUse)
+        : StreamingRenderPipeline(rendererToUse, codecPoolToUse, Options())
+    {
+    }
+
+    StreamingRenderPipeline(OfflineRenderer& rendererToUse, ThreadPool& codecPoolToUse, const Options& optionsToUse)
+        : renderer(rendererToUse), codecPool(codecPoolToUse), options(optionsToUse),
+          freeBlocks(jmax(2, options.numBlocks)),
+          decodedBlocks(jmax(2, options.numBlocks)),
+          processedBlocks(jmax(2, options.numBlocks))
+    {
+    }
+
+    /** True for files worth streaming: anything that isn't uncompressed PCM */
+    static bool isCompressedFormat(const File& file)
+    {
+        return ! file.hasFileExtension("wav;wave;aif;aiff");
+    }
+
+    /** Render one file, producing the same output and QC report as OfflineRenderer::renderFile() */
+    Result renderFile(const File& inputFile, const File& outputFile, const OfflineRenderer::Settings& settings)
+    {
+        if (settings.blockSize <= 0)
+            return Result::fail("Invalid block size " + String(settings.blockSize) + " for " + inputFile.getFullPathName());
+
+        std::unique_ptr<AudioFormatReader> reader(renderer.getFormatManager().createReaderFor(inputFile));
+
+        if (reader == nullptr)
+            return Result::fail("Could not read " + inputFile.getFullPathName());
+
+        std::unique_ptr<AudioFormatWriter> writer;
+        auto writerResult = renderer.createWriter(outputFile, *reader, settings, writer);
+
+        if (writerResult.failed())
+            return writerResult;
+
+        auto numChannels = static_cast<int>(reader->numChannels);
+        prepareBlocks(numChannels, settings.blockSize);
+
+        // DSP stage, on this thread
+        SimpleCompressor compressor;
+        DynamicsStatistics statistics;
+        Array<DynamicsStatistics::Event> events;
+        ScopedNoDenormals noDenormals;
+
+        OfflineRenderer::prepareCompressor(compressor, statistics, settings, reader->sampleRate);
+
+        std::unique_ptr<GainEnvelopeWriter> envelopeWriter;
+        AudioBuffer<float> gainReduction;
+        auto envelopeResult = OfflineRenderer::createGainEnvelopeWriter(outputFile, settings, reader->sampleRate, numChannels,
+                                                                        compressor, gainReduction, envelopeWriter);
+
+        if (envelopeResult.failed())
+            return envelopeResult;
+
+        DecodeJob decoder(*this, *reader, inputFile);
+        EncodeJob encoder(*this, *writer, outputFile);
+        codecPool.addJob(&decoder, false);
+        codecPool.addJob(&encoder, false);
+
+        int index = 0;
+
+        while (waitForBlock(decodedBlocks, dspWake, index))
+        {
+            auto& block = blocks[(size_t) index];
+            auto numSamples = block.numSamples;  // the block belongs to the encoder once pushed
+
+            if (numSamples > 0)
+            {
+                AudioBuffer<float> buffer(block.buffer.getArrayOfWritePointers(), numChannels, 0, numSamples);
+                compressor.processBuffer(buffer);
+                OfflineRenderer::drainEvents(statistics, events);
+
+                if (envelopeWriter != nullptr)
+                    envelopeWriter->write(gainReduction, numSamples);
+            }
+
+            processedBlocks.push(index);
+            encoderWake.signal();
+
+            if (numSamples == 0)
+                break;
+        }
+
+        codecPool.waitForJobToFinish(&decoder, -1);
+        codecPool.waitForJobToFinish(&encoder, -1);
+
+        writer = nullptr;
+
+        if (decoder.result.failed())
+            return decoder.result;
+
+        if (encoder.result.failed())
+            return encoder.result;
+
+        if (envelopeWriter != nullptr && ! envelopeWriter->finish())
+            return Result::fail("Could not write gain envelope for " + outputFile.getFullPathName());
+
+        if (settings.writeQCReport)
+            return OfflineRenderer::writeQCReport(statistics, numChannels, events, inputFile, outputFile);
+
+        return Result::ok();
+    }
+
+private:
+    //==============================================================================
+    struct Block
+    {
+        AudioBuffer<float> buffer;
+        int numSamples = 0;         // 0 marks the end of the file
+    };
+
+    /** Lock-free single-producer/single-consumer queue of block indices */
+    class BlockQueue
+    {
+    public:
+        explicit BlockQueue(int maxBlocks) : fifo(maxBlocks + 1), slots((size_t) maxBlocks + 1) {}
+
+        /** Never fails: a queue has room for every block in the pool */
+        void push(int index)
+        {
+            const auto scope = fifo.write(1);
+            jassert(scope.blockSize1 + scope.blockSize2 == 1);
+            slots[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = index;
+        }
+
+        bool pop(int& index)
+        {
+            const auto scope = fifo.read(1);
+
+            if (scope.blockSize1 + scope.blockSize2 == 0)
+                return false;
+
+            index = slots[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+            return true;
+        }
+
+        /** Only while no stage is running */
+        void reset() { fifo.reset(); }
+
+    private:
+        AbstractFifo fifo;
+        std::vector<int> slots;
+    };
+
+    //==============================================================================
+    class DecodeJob : public ThreadPoolJob
+    {
+    public:
+        DecodeJob(StreamingRenderPipeline& ownerToUse, AudioFormatReader& readerToUse, const File& file)
+            : ThreadPoolJob("Streaming decoder"), owner(ownerToUse), reader(readerToUse), inputFile(file)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            for (int slice = 0; slice < owner.options.blocksPerSlice; ++slice)
+            {
+                if (shouldExit() || owner.cancelled.load())
+                    return jobHasFinished;
+
+                int index;
+
+                if (! owner.freeBlocks.pop(index))
+                {
+                    owner.decoderWake.wait(1);
+                    return jobNeedsRunningAgain;
+                }
+
+                auto& block = owner.blocks[(size_t) index];
+                block.numSamples = static_cast<int>(std::min<int64>(owner.blockSize, reader.lengthInSamples - position));
+
+                if (block.numSamples > 0)
+                {
+                    AudioBuffer<float> buffer(block.buffer.getArrayOfWritePointers(), owner.numChannels, 0, block.numSamples);
+
+                    if (! reader.read(&buffer, 0, block.numSamples, position, true, true))
+                    {
+                        result = Result::fail("Read error in " + inputFile.getFullPathName());
+                        owner.cancel();
+                        return jobHasFinished;
+                    }
+
+                    position += block.numSamples;
+                }
+
+                owner.decodedBlocks.push(index);
+                owner.dspWake.signal();
+
+                if (block.numSamples == 0)
+                    return jobHasFinished;
+            }
+
+            return jobNeedsRunningAgain;
+        }
+
+        Result result = Result::ok();
+
+    private:
+        StreamingRenderPipeline& owner;
+        AudioFormatReader& reader;
+        File inputFile;
+        int64 position = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodeJob)
+    };
+
+    class EncodeJob : public ThreadPoolJob
+    {
+    public:
+        EncodeJob(StreamingRenderPipeline& ownerToUse, AudioFormatWriter& writerToUse, const File& file)
+            : ThreadPoolJob("Streaming encoder"), owner(ownerToUse), writer(writerToUse), outputFile(file)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            for (int slice = 0; slice < owner.options.blocksPerSlice; ++slice)
+            {
+                if (shouldExit() || owner.cancelled.load())
+                    return jobHasFinished;
+
+                int index;
+
+                if (! owner.processedBlocks.pop(index))
+                {
+                    owner.encoderWake.wait(1);
+                    return jobNeedsRunningAgain;
+                }
+
+                auto& block = owner.blocks[(size_t) index];
+
+                if (block.numSamples == 0)
+                    return jobHasFinished;
+
+                AudioBuffer<float> buffer(block.buffer.getArrayOfWritePointers(), owner.numChannels, 0, block.numSamples);
+
+                if (! writer.writeFromAudioSampleBuffer(buffer, 0, block.numSamples))
+                {
+                    result = Result::fail("Write error in " + outputFile.getFullPathName());
+                    owner.cancel();
+                    return jobHasFinished;
+                }
+
+                owner.freeBlocks.push(index);
+                owner.decoderWake.signal();
+            }
+
+            return jobNeedsRunningAgain;
+        }
+
+        Result result = Result::ok();
+
+    private:
+        StreamingRenderPipeline& owner;
+        AudioFormatWriter& writer;
+        File outputFile;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EncodeJob)
+    };
+
+    //==============================================================================
+    /** Allocate the block pool if it's too small, and put every block on the free queue */
+    void prepareBlocks(int newNumChannels, int newBlockSize)
+    {
+        numChannels = newNumChannels;
+        blockSize = newBlockSize;
+
+        auto numBlocks = jmax(2, options.numBlocks);
+        blocks.resize((size_t) numBlocks);
+
+        for (auto& block : blocks)
+            if (block.buffer.getNumChannels() < numChannels || block.buffer.getNumSamples() < blockSize)
+                block.buffer.setSize(numChannels, blockSize);
+
+        freeBlocks.reset();
+        decodedBlocks.reset();
+        processedBlocks.reset();
+        cancelled = false;
+
+        for (int index = 0; index < numBlocks; ++index)
+            freeBlocks.push(index);
+    }
+
+    /** DSP stage: wait for the next block, or return false if the render was cancelled */
+    bool waitForBlock(BlockQueue& queue, WaitableEvent& wake, int& index)
+    {
+        while (! queue.pop(index))
+        {
+            if (cancelled.load())
+                return false;
+
+            wake.wait(1);
+        }
+
+        return true;
+    }
+
+    void cancel()
+    {
+        cancelled = true;
+        decoderWake.signal();
+        dspWake.signal();
+        encoderWake.signal();
+    }
+
+    //==============================================================================
+    OfflineRenderer& renderer;
+    ThreadPool& codecPool;
+    Options options;
+
+    std::vector<Block> blocks;
+    int numChannels = 0;
+    int blockSize = 0;
+
+    BlockQueue freeBlocks, decodedBlocks, processedBlocks;
+    WaitableEvent decoderWake, dspWake, encoderWake;
+    std::atomic<bool> cancelled { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StreamingRenderPipeline)
+};
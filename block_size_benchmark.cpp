@@ -0,0 +1,112 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <iomanip>
+#include "AudioPluginDemo/Source/AudioPluginDemo.h"
+
+/**
+ * CPU cost per sample of the plugin at tiny host buffer sizes, with and
+ * without the fixed internal block mode.
+ * Runs the real processor (parameter reads, QC statistics, idle detection)
+ * over a stereo programme of enveloped tones at host buffers of 1, 8, 16,
+ * 64 and 512 samples, once following the host and once each with 64 and
+ * 128-sample internal blocks.
+ *
+ * Usage: block_size_benchmark [seconds of audio per run]
+ */
+
+static AudioBuffer<float> makeProgramme(double sampleRate, double seconds)
+{
+    AudioBuffer<float> programme(2, static_cast<int>(sampleRate * seconds));
+    Random random(1234);
+
+    for (int channel = 0; channel < programme.getNumChannels(); ++channel)
+    {
+        auto* data = programme.getWritePointer(channel);
+
+        for (int i = 0; i < programme.getNumSamples(); ++i)
+        {
+            auto t = i / sampleRate;
+            auto envelope = 0.5f + 0.45f * std::sin(MathConstants<float>::twoPi * 0.7f * (float) t);
+            data[i] = envelope * (0.6f * std::sin(MathConstants<float>::twoPi * 220.0f * (float) t)
+                                  + 0.05f * (random.nextFloat() * 2.0f - 1.0f));
+        }
+    }
+
+    return programme;
+}
+
+static double measureNanosecondsPerSample(JuceDemoPluginAudioProcessor& processor, const AudioBuffer<float>& programme,
+                                          double sampleRate, int hostBlockSize, int internalBlockSize)
+{
+    processor.setInternalBlockSize(internalBlockSize);
+    processor.setRateAndBufferSizeDetails(sampleRate, hostBlockSize);
+    processor.prepareToPlay(sampleRate, hostBlockSize);
+    processor.reset();
+
+    AudioBuffer<float> hostBuffer(programme.getNumChannels(), hostBlockSize);
+    MidiBuffer midi;
+    auto numSamples = programme.getNumSamples() - programme.getNumSamples() % hostBlockSize;
+
+    auto start = Time::getHighResolutionTicks();
+
+    for (int position = 0; position < numSamples; position += hostBlockSize)
+    {
+        for (int channel = 0; channel < hostBuffer.getNumChannels(); ++channel)
+            hostBuffer.copyFrom(channel, 0, programme, channel, position, hostBlockSize);
+
+        processor.processBlock(hostBuffer, midi);
+    }
+
+    auto seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+    processor.releaseResources();
+
+    return seconds * 1.0e9 / numSamples;
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto seconds = argc > 1 ? std::max(1.0, String(argv[1]).getDoubleValue()) : 20.0;
+    const double sampleRate = 48000.0;
+    const int hostBlockSizes[] = { 1, 8, 16, 64, 512 };
+    const int internalBlockSizes[] = { 0, 64, 128 };
+
+    std::cout << "=== BLOCK SIZE BENCHMARK ===" << std::endl;
+    std::cout << "Programme: " << seconds << " s stereo at " << sampleRate << " Hz" << std::endl;
+    std::cout << std::endl;
+
+    auto programme = makeProgramme(sampleRate, seconds);
+    JuceDemoPluginAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, sampleRate, 512);
+
+    std::cout << std::setw(10) << "host" << std::setw(14) << "follow host"
+              << std::setw(14) << "fixed 64" << std::setw(14) << "fixed 128"
+              << std::setw(12) << "speed-up" << std::endl;
+    std::cout << std::setw(10) << "(samples)" << std::setw(14) << "(ns/sample)"
+              << std::setw(14) << "(ns/sample)" << std::setw(14) << "(ns/sample)"
+              << std::setw(12) << "(best)" << std::endl;
+
+    for (auto hostBlockSize : hostBlockSizes)
+    {
+        double results[3];
+
+        for (int mode = 0; mode < 3; ++mode)
+            results[mode] = measureNanosecondsPerSample(processor, programme, sampleRate,
+                                                        hostBlockSize, internalBlockSizes[mode]);
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << std::setw(10) << hostBlockSize
+                  << std::setw(14) << results[0]
+                  << std::setw(14) << results[1]
+                  << std::setw(14) << results[2]
+                  << std::setw(11) << results[0] / std::min(results[1], results[2]) << "x" << std::endl;
+    }
+
+    std::cout << std::endl;
+    std::cout << "Latency added: 64 or 128 samples ("
+              << std::setprecision(2) << 64000.0 / sampleRate << " / " << 128000.0 / sampleRate
+              << " ms), reported to the host through setLatencySamples." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "AudioPluginDemo/Source/AudioPluginDemo.h"
+
+/**
+ * Per-block CPU time on exponentially fading tails.
+ * A loud tone decays at 400 dB/s, through the float denormal range
+ * (about -760 to -900 dBFS) and on to silence, with a long release so the
+ * envelope decays alongside it. The plugin's processBlock (FTZ/DAZ plus
+ * explicit state flushing) is timed block by block, and the bare
+ * SimpleCompressor without FTZ/DAZ is shown for comparison.
+ *
+ * Each block's time is the minimum over several passes, to take scheduler
+ * noise out. Exits with a non-zero status if any block of the protected path
+ * takes more than maxSpikeRatio times the median block.
+ *
+ * Usage: denormal_tail_benchmark [passes]
+ */
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int blockSize = 256;
+static constexpr double maxSpikeRatio = 4.0;
+
+static AudioBuffer<float> makeFadingTail(double seconds, double decayDbPerSecond)
+{
+    AudioBuffer<float> tail(2, static_cast<int>(sampleRate * seconds));
+
+    for (int channel = 0; channel < tail.getNumChannels(); ++channel)
+    {
+        auto* data = tail.getWritePointer(channel);
+
+        for (int i = 0; i < tail.getNumSamples(); ++i)
+        {
+            auto t = i / sampleRate;
+            auto level = std::pow(10.0, -decayDbPerSecond * t / 20.0);
+            data[i] = static_cast<float>(0.9 * level * std::sin(MathConstants<double>::twoPi * 1000.0 * t + channel));
+        }
+    }
+
+    return tail;
+}
+
+template <typename ProcessBlock>
+static std::vector<double> timeBlocks(const AudioBuffer<float>& tail, int passes, ProcessBlock&& processBlock)
+{
+    auto numBlocks = tail.getNumSamples() / blockSize;
+    std::vector<double> best((size_t) numBlocks, 1.0e9);
+    AudioBuffer<float> block(tail.getNumChannels(), blockSize);
+
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (int index = 0; index < numBlocks; ++index)
+        {
+            for (int channel = 0; channel < tail.getNumChannels(); ++channel)
+                block.copyFrom(channel, 0, tail, channel, index * blockSize, blockSize);
+
+            auto start = Time::getHighResolutionTicks();
+            processBlock(block);
+            auto micros = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1.0e6;
+
+            best[(size_t) index] = std::min(best[(size_t) index], micros);
+        }
+    }
+
+    return best;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto passes = argc > 1 ? std::max(1, String(argv[1]).getIntValue()) : 5;
+    auto tail = makeFadingTail(2.5, 400.0);
+
+    std::cout << "=== DENORMAL TAIL BENCHMARK ===" << std::endl;
+    std::cout << "Tail: 2.5 s stereo, 400 dB/s decay, " << blockSize << "-sample blocks, "
+              << passes << " passes" << std::endl;
+    std::cout << std::endl;
+
+    // Plugin path: ScopedNoDenormals in processBlock plus the envelope floor
+    JuceDemoPluginAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor.state.getParameter("release")->setValueNotifyingHost(1.0f);    // 400 ms
+    processor.state.getParameter("threshold")->setValueNotifyingHost(0.5f);  // -30 dB
+    processor.prepareToPlay(sampleRate, blockSize);
+    MidiBuffer midi;
+
+    auto protectedTimes = timeBlocks(tail, passes, [&](AudioBuffer<float>& block)
+    {
+        processor.processBlock(block, midi);
+    });
+
+    // Bare compressor on this thread's default floating-point mode
+    SimpleCompressor compressor;
+    compressor.prepareToPlay(sampleRate);
+    compressor.setParametersWithRatioPreset(-30.0f, 3, 10.0f, 400.0f, 0.0f);  // 4:1, as the plugin runs it
+
+    auto unprotectedTimes = timeBlocks(tail, passes, [&](AudioBuffer<float>& block)
+    {
+        compressor.processBuffer(block);
+    });
+
+    auto protectedMedian = median(protectedTimes);
+    auto unprotectedMedian = median(unprotectedTimes);
+    auto protectedWorst = *std::max_element(protectedTimes.begin(), protectedTimes.end());
+    auto unprotectedWorst = *std::max_element(unprotectedTimes.begin(), unprotectedTimes.end());
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(28) << "" << std::setw(14) << "median (us)" << std::setw(14) << "worst (us)"
+              << std::setw(14) << "worst/median" << std::endl;
+    std::cout << std::setw(28) << "processBlock (FTZ + flush)" << std::setw(14) << protectedMedian
+              << std::setw(14) << protectedWorst << std::setw(14) << protectedWorst / protectedMedian << std::endl;
+    std::cout << std::setw(28) << "SimpleCompressor, no FTZ" << std::setw(14) << unprotectedMedian
+              << std::setw(14) << unprotectedWorst << std::setw(14) << unprotectedWorst / unprotectedMedian << std::endl;
+    std::cout << std::endl;
+
+    // Where along the tail each path was slowest
+    auto worstIndex = (size_t) std::distance(protectedTimes.begin(),
+                                             std::max_element(protectedTimes.begin(), protectedTimes.end()));
+    std::cout << "Slowest protected block at " << std::setprecision(3)
+              << worstIndex * blockSize / sampleRate << " s ("
+              << -400.0 * worstIndex * blockSize / sampleRate << " dBFS)" << std::endl;
+
+    if (protectedWorst > maxSpikeRatio * protectedMedian)
+    {
+        std::cout << "FAIL: block time spike of " << std::setprecision(1) << protectedWorst / protectedMedian
+                  << "x the median on a fading tail" << std::endl;
+        return 1;
+    }
+
+    std::cout << "PASS: no block above " << std::setprecision(1) << maxSpikeRatio << "x the median" << std::endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <array>
+#include "AudioPluginDemo/Source/SimpleCompressor.h"
+
+/**
+ * Checks of the QC statistics SimpleCompressor feeds to DynamicsStatistics
+ * and the realtime log.
+ *
+ * Exits with a non-zero status if any check fails.
+ *
+ * Usage: dynamics_qc_test
+ */
+
+static constexpr double sampleRate = 48000.0;
+
+static int numFailures = 0;
+
+static void expect(bool condition, const String& description)
+{
+    std::cout << (condition ? "  pass: " : "  FAIL: ") << description << std::endl;
+
+    if (! condition)
+        ++numFailures;
+}
+
+//==============================================================================
+/** One channel held in the soft limiter, the other quiet: the limiter engages
+    once on the loud channel and never on the quiet one, however many blocks
+    go by.
+*/
+static void testSoftLimitIsPerChannel()
+{
+    std::cout << "Soft limiter engagements per channel" << std::endl;
+
+    const int blockSize = 512;
+    const int numBlocks = 100;
+
+    SimpleCompressor compressor;
+    DynamicsStatistics statistics;
+    RealtimeLogRing logRing("dynamics_qc_test", 4096);
+
+    compressor.setStatistics(&statistics);
+    compressor.setLogRing(&logRing);
+    compressor.prepareToPlay(sampleRate);
+    compressor.setParameters(0.0f, 1.0f, 10.0f, 100.0f, 6.0f);
+
+    AudioBuffer<float> block(2, blockSize);
+
+    for (int index = 0; index < numBlocks; ++index)
+    {
+        FloatVectorOperations::fill(block.getWritePointer(0), 0.9f, blockSize);   // +6 dB makeup puts this in the limiter
+        FloatVectorOperations::fill(block.getWritePointer(1), 0.01f, blockSize);
+        compressor.processBuffer(block);
+    }
+
+    auto loud = statistics.getChannelSnapshot(0);
+    auto quiet = statistics.getChannelSnapshot(1);
+
+    expect(loud.softLimitEngagements == 1, "loud channel engages once (got " + String((int64) loud.softLimitEngagements) + ")");
+    expect(loud.softLimitedSamples == (uint64) (blockSize * numBlocks), "every loud sample is soft limited");
+    expect(quiet.softLimitEngagements == 0, "quiet channel never engages (got " + String((int64) quiet.softLimitEngagements) + ")");
+
+    LogRecord records[64];
+    auto numRecords = logRing.pop(records, 64);
+    auto engagedRecords = 0;
+
+    for (int i = 0; i < numRecords; ++i)
+        if (records[i].event == RealtimeLogEvent::softLimitEngaged)
+            ++engagedRecords;
+
+    expect(engagedRecords == 1, "one softLimitEngaged log record (got " + String(engagedRecords) + ")");
+}
+
+//==============================================================================
+/** Channel 0's statistics for a programme processed in blocks of blockSize */
+static DynamicsStatistics::ChannelSnapshot snapshotAtBlockSize(const AudioBuffer<float>& programme, int blockSize)
+{
+    SimpleCompressor compressor;
+    DynamicsStatistics statistics;
+
+    compressor.setStatistics(&statistics);
+    compressor.prepareToPlay(sampleRate);
+    compressor.setParameters(-40.0f, 4.0f, 1.0f, 50.0f, 0.0f);
+
+    AudioBuffer<float> block(programme.getNumChannels(), blockSize);
+
+    for (int position = 0; position + blockSize <= programme.getNumSamples(); position += blockSize)
+    {
+        for (int channel = 0; channel < programme.getNumChannels(); ++channel)
+            block.copyFrom(channel, 0, programme, channel, position, blockSize);
+
+        compressor.processBuffer(block);
+    }
+
+    return statistics.getChannelSnapshot(0);
+}
+
+/** The gain reduction histogram counts samples, so the same programme gives the
+    same histogram whatever block size it is processed in.
+*/
+static void testHistogramIndependentOfBlockSize()
+{
+    std::cout << "Gain reduction histogram at 64 and 2048-sample blocks" << std::endl;
+
+    // Mono: the envelope is shared between channels, so only a single channel
+    // is processed identically at every block size. Just over 2 s, in whole
+    // 2048-sample blocks.
+    AudioBuffer<float> programme(1, 48 * 2048);
+    auto* data = programme.getWritePointer(0);
+
+    for (int i = 0; i < programme.getNumSamples(); ++i)
+    {
+        auto t = i / sampleRate;
+        auto level = std::pow(10.0, (-50.0 + 25.0 * t) / 20.0);   // -50 dBFS rising to about 0 dBFS
+        data[i] = static_cast<float>(level * std::sin(MathConstants<double>::twoPi * 110.0 * t));
+    }
+
+    auto small = snapshotAtBlockSize(programme, 64).gainReductionHistogram;
+    auto large = snapshotAtBlockSize(programme, 2048).gainReductionHistogram;
+
+    uint64 smallTotal = 0, usedBins = 0;
+
+    for (int bin = 0; bin < DynamicsStatistics::numHistogramBins; ++bin)
+    {
+        smallTotal += small[(size_t) bin];
+        usedBins += small[(size_t) bin] > 0 ? 1 : 0;
+    }
+
+    expect(smallTotal == (uint64) programme.getNumSamples(), "histogram counts every sample");
+    expect(usedBins > 10, "programme covers a range of gain reduction (" + String((int64) usedBins) + " bins)");
+    expect(small == large, "histograms match");
+}
+
+//==============================================================================
+/** Overloads are counted once when they start, so a burst that spans many
+    blocks is one event at any block size.
+*/
+static void testOverloadOnsetsIndependentOfBlockSize()
+{
+    std::cout << "Overload events at 64 and 2048-sample blocks" << std::endl;
+
+    // Three bursts of square wave over full scale, each four 2048-sample blocks long
+    const int numBursts = 3;
+    AudioBuffer<float> programme(1, 48 * 2048);
+    auto* data = programme.getWritePointer(0);
+
+    for (int i = 0; i < programme.getNumSamples(); ++i)
+    {
+        auto inBurst = (i / 8192) % 4 == 1 && i < numBursts * 4 * 8192;
+        data[i] = inBurst ? ((i / 16) % 2 == 0 ? 1.2f : -1.2f) : 0.1f;
+    }
+
+    auto small = snapshotAtBlockSize(programme, 64);
+    auto large = snapshotAtBlockSize(programme, 2048);
+
+    expect(small.overloadEvents == (uint64) numBursts, "one event per burst at 64 samples (got " + String((int64) small.overloadEvents) + ")");
+    expect(large.overloadEvents == (uint64) numBursts, "one event per burst at 2048 samples (got " + String((int64) large.overloadEvents) + ")");
+}
+
+//==============================================================================
+int main()
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::cout << "=== DYNAMICS QC TEST ===" << std::endl;
+
+    testSoftLimitIsPerChannel();
+    testHistogramIndependentOfBlockSize();
+    testOverloadOnsetsIndependentOfBlockSize();
+
+    std::cout << std::endl;
+    std::cout << (numFailures == 0 ? "PASS" : "FAIL: " + std::to_string(numFailures) + " check(s) failed") << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "AudioPluginDemo/Source/AudioPluginDemo.h"
+#include "AudioPluginDemo/Source/EditorRenderBenchmark.h"
+
+/**
+ * Headless rendering benchmark for the compressor editor.
+ * Paints the editor into a software image at 1x/2x scale and at both resize
+ * limits (700x700 and 1200x1000) with the meters animating.
+ * Needs no display, so it runs on CI and headless Linux render boxes.
+ *
+ * Usage: editor_render_benchmark [numFrames]
+ */
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto numFrames = argc > 1 ? std::max(1, String(argv[1]).getIntValue()) : 200;
+
+    JuceDemoPluginAudioProcessor processor;
+    std::unique_ptr<AudioProcessorEditor> editor(processor.createEditorIfNeeded());
+
+    auto* compressorEditor = dynamic_cast<CompressorEditor*>(editor.get());
+
+    if (compressorEditor == nullptr)
+    {
+        std::cerr << "Processor did not create a CompressorEditor" << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== EDITOR RENDER BENCHMARK ===" << std::endl;
+    std::cout << "Frames per configuration: " << numFrames << std::endl;
+    std::cout << std::endl;
+
+    EditorRenderBenchmark benchmark(*compressorEditor);
+
+    for (auto& result : benchmark.runStandardSuite(numFrames))
+        std::cout << EditorRenderBenchmark::formatResult(result) << std::endl;
+
+    editor = nullptr;
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <vector>
 
 /**
  * Analysis of extreme compressor settings without JUCE dependencies
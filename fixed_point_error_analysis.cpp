@@ -0,0 +1,286 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include "AudioPluginDemo/Source/SimpleCompressor.h"
+#include "AudioPluginDemo/Source/FixedPointCompressor.h"
+
+/**
+ * Error analysis of FixedPointCompressor against the float SimpleCompressor.
+ *
+ * Checks every bound documented in FixedPointCompressor.h:
+ *   - each table-driven stage (detector, gain, soft limiter) against its float
+ *     counterpart over its whole input range
+ *   - the envelope and the Q31/Q15 output against SimpleCompressor itself over
+ *     sines, noise and release tails at 44.1/48/96 kHz and every ratio preset
+ *   - bit-exact output, against golden checksums of a fixed integer input
+ *
+ * SimpleCompressor's soft limiter jumps from 0.95 to tanh(0.76) * 0.95 at its
+ * knee, so samples whose unlimited output is within 1e-3 of the knee are
+ * excluded: any rounding difference there flips the branch.
+ *
+ * Exits with a non-zero status if any bound is exceeded.
+ *
+ * Usage: fixed_point_error_analysis
+ */
+
+static int numFailures = 0;
+
+static void report(const std::string& name, double worst, double bound, const std::string& unit)
+{
+    auto passed = worst < bound;
+
+    std::cout << (passed ? "  pass: " : "  FAIL: ") << std::setw(34) << std::left << name << std::right
+              << std::scientific << std::setprecision(2) << worst << " " << unit
+              << " (bound " << bound << ")" << std::defaultfloat << std::setprecision(6) << std::endl;
+
+    if (! passed)
+        ++numFailures;
+}
+
+//==============================================================================
+static constexpr double fullScale = 2147483648.0;
+
+static double detectorError()
+{
+    // Every octave of the Q31 range, 4096 steps per octave
+    double worst = 0.0;
+
+    for (int octave = 0; octave < 31; ++octave)
+    {
+        for (int step = 0; step < 4096; ++step)
+        {
+            auto magnitude = std::ldexp(1.0 + step / 4096.0, octave);
+            auto sample = static_cast<int32_t>(std::min(magnitude, fullScale - 1.0));
+
+            auto expected = std::max(-120.0, std::min(20.0, 20.0 * std::log10(sample / fullScale)));
+
+            for (auto signedSample : { sample, -sample })
+                worst = std::max(worst, std::abs(FixedPointCompressor::fixedToDb(FixedPointCompressor::levelInDb(signedSample)) - expected));
+        }
+    }
+
+    return worst;
+}
+
+static double gainError()
+{
+    // -60 to +20 dB in 0.001 dB steps
+    double worst = 0.0;
+
+    for (int step = 0; step <= 80000; ++step)
+    {
+        auto gainInDb = -60.0f + step * 0.001f;
+        auto fixedGain = FixedPointCompressor::dbToLinearGain(FixedPointCompressor::dbToFixed(gainInDb));
+
+        worst = std::max(worst, std::abs(20.0 * std::log10(fixedGain / 134217728.0) - gainInDb));
+    }
+
+    return worst;
+}
+
+static double softLimitError()
+{
+    // Everything the gain stage can send into the limiter: 0.95 to 10 x full scale
+    double worst = 0.0;
+
+    for (int step = 0; step <= 90500; ++step)
+    {
+        auto x = 0.95 + step * 1.0e-4;
+        auto sample = static_cast<int64_t>(std::llround(x * fullScale));
+        auto expected = std::tanh(x * 0.8) * 0.95;
+
+        worst = std::max(worst, std::abs(FixedPointCompressor::softLimit(sample) / fullScale - expected));
+        worst = std::max(worst, std::abs(FixedPointCompressor::softLimit(-sample) / fullScale + expected));
+    }
+
+    return worst;
+}
+
+//==============================================================================
+static std::vector<float> makeSignal(const std::string& kind, double sampleRate, int numSamples)
+{
+    std::vector<float> signal(static_cast<size_t>(numSamples));
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto t = static_cast<float>(i / sampleRate);
+
+        if (kind == "sine")
+            signal[(size_t) i] = 0.9f * std::sin(2.0f * 3.14159265f * 440.0f * t);
+        else if (kind == "noise")
+            signal[(size_t) i] = 0.7f * noise(random);
+        else // burst then a release tail into silence
+            signal[(size_t) i] = (t < 0.25f ? 0.99f : 0.001f * std::exp(-8.0f * t)) * std::sin(2.0f * 3.14159265f * 1000.0f * t);
+    }
+
+    return signal;
+}
+
+/** SimpleCompressor's output before the soft limiter, from its envelope */
+static float unlimitedOutput(float input, float envelope, float makeupGain)
+{
+    auto gainInDb = jlimit(-60.0f, 20.0f, makeupGain - envelope);
+    return input * jlimit(0.001f, 10.0f, std::pow(10.0f, gainInDb / 20.0f));
+}
+
+struct SignalErrors
+{
+    double q31 = 0.0;     // fraction of full scale
+    double q15 = 0.0;     // LSB
+    double envelope = 0.0; // dB
+};
+
+static SignalErrors signalErrors(const std::vector<float>& signal, double sampleRate, float ratio)
+{
+    const float threshold = -24.0f, attack = 5.0f, release = 120.0f, makeupGain = 6.0f;
+
+    SimpleCompressor reference;
+    reference.prepareToPlay(sampleRate);
+    reference.setParameters(threshold, ratio, attack, release, makeupGain);
+
+    FixedPointCompressor fixed32, fixed16;
+
+    for (auto* fixed : { &fixed32, &fixed16 })
+    {
+        fixed->prepareToPlay(sampleRate);
+        fixed->setParameters(threshold, ratio, attack, release, makeupGain);
+    }
+
+    SignalErrors errors;
+
+    for (auto input : signal)
+    {
+        auto expected = reference.processSample(input);
+        auto nearKnee = std::abs(std::abs(unlimitedOutput(input, reference.getCurrentEnvelope(), makeupGain)) - 0.95f) < 1e-3f;
+
+        auto q31 = static_cast<int32_t>(std::lround(std::max(-1.0, std::min(1.0 - 1e-9, (double) input)) * fullScale));
+        auto actual31 = fixed32.processSample(q31);
+
+        int16_t q15 = static_cast<int16_t>(std::max(-32768L, std::min(32767L, std::lround(input * 32768.0f))));
+        int16_t* channels[] = { &q15 };
+        fixed16.processBlock(channels, 1, 1);
+
+        if (! nearKnee)
+        {
+            errors.q31 = std::max(errors.q31, std::abs(actual31 / fullScale - expected));
+            errors.q15 = std::max(errors.q15, (double) std::abs(q15 - std::lround(expected * 32768.0f)));
+        }
+
+        errors.envelope = std::max(errors.envelope, (double) std::abs(FixedPointCompressor::fixedToDb(fixed32.getCurrentEnvelope())
+                                                                       - reference.getCurrentEnvelope()));
+    }
+
+    return errors;
+}
+
+//==============================================================================
+/** FNV-1a over the Q31 and Q15 output of a fixed integer input, which needs
+    no libm and so is the same everywhere. The fixed-point path is bit-exact,
+    so these checksums may only change together with its arithmetic.
+*/
+static constexpr uint64_t goldenQ31 = 0xaf47f00c985793e6ull;
+static constexpr uint64_t goldenQ15 = 0x2d6e33c1335ac9d3ull;
+
+static void fnv1a(uint64_t& hash, uint32_t value)
+{
+    for (int byte = 0; byte < 4; ++byte)
+    {
+        hash ^= (value >> (8 * byte)) & 0xff;
+        hash *= 0x100000001b3ull;
+    }
+}
+
+static void checkGoldenVectors()
+{
+    FixedPointCompressor fixed32, fixed16;
+
+    for (auto* fixed : { &fixed32, &fixed16 })
+    {
+        fixed->prepareToPlay(48000.0);
+        fixed->setParameters(-18.0f, 4.0f, 2.0f, 80.0f, 12.0f);
+    }
+
+    uint64_t hash31 = 0xcbf29ce484222325ull, hash15 = hash31;
+    uint32_t state = 22222;
+
+    // Loud noise bursts (into the soft limiter), quiet noise and silence
+    for (int i = 0; i < 48000; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        auto noise = static_cast<int32_t>(state);
+        auto phase = (i / 4000) % 3;
+        auto input = phase == 0 ? noise : (phase == 1 ? noise >> 8 : 0);
+
+        fnv1a(hash31, static_cast<uint32_t>(fixed32.processSample(input)));
+
+        int16_t q15 = static_cast<int16_t>(input >> 16);
+        int16_t* channels[] = { &q15 };
+        fixed16.processBlock(channels, 1, 1);
+        fnv1a(hash15, static_cast<uint16_t>(q15));
+    }
+
+    auto matches31 = hash31 == goldenQ31, matches15 = hash15 == goldenQ15;
+
+    std::cout << std::hex << std::setfill('0')
+              << (matches31 ? "  pass: " : "  FAIL: ") << "Q31 golden checksum 0x" << std::setw(16) << hash31 << std::endl
+              << (matches15 ? "  pass: " : "  FAIL: ") << "Q15 golden checksum 0x" << std::setw(16) << hash15 << std::endl
+              << std::dec << std::setfill(' ');
+
+    numFailures += (matches31 ? 0 : 1) + (matches15 ? 0 : 1);
+}
+
+//==============================================================================
+int main()
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::cout << "=== FIXED-POINT COMPRESSOR ERROR ANALYSIS ===" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Stages" << std::endl;
+    report("detector level", detectorError(), 0.002, "dB");
+    report("applied gain", gainError(), 0.002, "dB");
+    report("soft limiter", softLimitError(), 1e-4, "FS");
+    std::cout << std::endl;
+
+    const float ratios[] = { 1.0f, 2.0f, 3.0f, 4.0f, 6.0f, 8.0f, 10.0f, 20.0f };
+
+    for (auto sampleRate : { 44100, 48000, 96000 })
+    {
+        for (auto kind : { "sine", "noise", "tail" })
+        {
+            std::cout << kind << " @ " << sampleRate << " Hz" << std::endl;
+
+            auto signal = makeSignal(kind, sampleRate, sampleRate);
+            SignalErrors worst;
+
+            for (auto ratio : ratios)
+            {
+                auto errors = signalErrors(signal, sampleRate, ratio);
+                worst.q31 = std::max(worst.q31, errors.q31);
+                worst.q15 = std::max(worst.q15, errors.q15);
+                worst.envelope = std::max(worst.envelope, errors.envelope);
+            }
+
+            report("envelope", worst.envelope, 0.01, "dB");
+            report("Q31 output", worst.q31, 2e-4, "FS");
+            report("Q15 output", worst.q15, 8.0, "LSB");
+        }
+    }
+
+    std::cout << std::endl;
+    std::cout << "Bit-exact output" << std::endl;
+    checkGoldenVectors();
+
+    std::cout << std::endl;
+    std::cout << (numFailures == 0 ? "PASS" : "FAIL: " + std::to_string(numFailures) + " bound(s) exceeded") << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <random>
+#include "AudioPluginDemo/Source/GainEnvelopeSidecar.h"
+
+/**
+ * Round trip through GainEnvelopeWriter and GainEnvelopeReader: curves the
+ * writer can decimate come back exactly, any range reads back the same as a
+ * sequential read, and files with a corrupt block index are rejected.
+ *
+ * Exits with a non-zero status if any check fails.
+ *
+ * Usage: gain_envelope_sidecar_test
+ */
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int numChannels = 2;
+
+static int numFailures = 0;
+
+static void expect(bool condition, const String& description)
+{
+    std::cout << (condition ? "  pass: " : "  FAIL: ") << description << std::endl;
+
+    if (! condition)
+        ++numFailures;
+}
+
+//==============================================================================
+/** Writes the curve in uneven chunks, as a render with a changing block size would */
+static bool writeEnvelope(const File& file, const AudioBuffer<float>& curve, const GainEnvelopeWriter::Options& options)
+{
+    GainEnvelopeWriter writer(file, sampleRate, curve.getNumChannels(), 6.0f, options);
+
+    if (! writer.openedOk())
+        return false;
+
+    const int chunkSizes[] = { 1, 511, 64, 1000, 3 };
+    AudioBuffer<float> chunk(curve.getNumChannels(), 1000);
+
+    for (int position = 0, index = 0; position < curve.getNumSamples(); ++index)
+    {
+        auto numSamples = jmin(chunkSizes[index % numElementsInArray(chunkSizes)], curve.getNumSamples() - position);
+
+        for (int channel = 0; channel < curve.getNumChannels(); ++channel)
+            chunk.copyFrom(channel, 0, curve, channel, position, numSamples);
+
+        writer.write(chunk, numSamples);
+        position += numSamples;
+    }
+
+    return writer.finish();
+}
+
+static float worstError(const AudioBuffer<float>& a, const AudioBuffer<float>& b, int numSamples)
+{
+    auto worst = 0.0f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            worst = jmax(worst, std::abs(a.getReadPointer(channel)[i] - b.getReadPointer(channel)[i]));
+
+    return worst;
+}
+
+//==============================================================================
+/** Piecewise-linear curves with their knots on the decimation grid: the writer
+    keeps only the knots, and linear interpolation gives the curve back to
+    within the quantisation.
+*/
+static void testExactDecimation()
+{
+    std::cout << "Decimation of piecewise-linear curves" << std::endl;
+
+    GainEnvelopeWriter::Options options;
+    const int numBlocks = 8;
+    AudioBuffer<float> curve(numChannels, numBlocks * options.blockSize);
+
+    // Knot values are whole multiples of the quantisation step
+    auto knot = [] (int index) { return static_cast<float>((index * 37) % 11) * 0.5f; };
+
+    for (int i = 0; i < curve.getNumSamples(); ++i)
+    {
+        auto segment = i / GainEnvelopeFormat::maxDecimation;
+        auto fraction = static_cast<float>(i % GainEnvelopeFormat::maxDecimation) / GainEnvelopeFormat::maxDecimation;
+
+        curve.getWritePointer(0)[i] = 4.5f;                                                     // held gain reduction
+        curve.getWritePointer(1)[i] = knot(segment) + (knot(segment + 1) - knot(segment)) * fraction;  // attack and release ramps
+    }
+
+    TemporaryFile temp(".grenv");
+    expect(writeEnvelope(temp.getFile(), curve, options), "writer finishes");
+
+    GainEnvelopeReader reader(temp.getFile());
+    expect(reader.openedOk(), "reader opens the file");
+    expect(reader.getLengthInSamples() == curve.getNumSamples(), "length matches");
+
+    AudioBuffer<float> decoded(numChannels, curve.getNumSamples());
+    expect(reader.read(decoded, 0, 0, curve.getNumSamples()), "whole file reads");
+
+    auto error = worstError(curve, decoded, curve.getNumSamples());
+    expect(error <= options.quantisationStep * 0.5f + 1.0e-5f, "curve is exact to the quantisation (worst " + String(error) + " dB)");
+
+    // Per block an index entry, then per channel two varints and a few bytes per 256 samples
+    auto maxBytes = 36 + 24 + numBlocks * (8 + numChannels * (4 + 3 * (options.blockSize / GainEnvelopeFormat::maxDecimation + 1)));
+    expect(temp.getFile().getSize() <= maxBytes, "file keeps only the knots (" + String(temp.getFile().getSize()) + " bytes)");
+}
+
+//==============================================================================
+/** Noise forces every sample to be kept. Random ranges, including ones that
+    start before the file, straddle blocks or run past the end, read back the
+    same values as one sequential read.
+*/
+static void testRandomSeek()
+{
+    std::cout << "Random seeks against a sequential read" << std::endl;
+
+    GainEnvelopeWriter::Options options;
+    options.blockSize = 1024;
+
+    std::mt19937 random(88);
+    std::uniform_real_distribution<float> noise(0.0f, 12.0f);
+
+    // Not a whole number of blocks, so the last block is partial
+    AudioBuffer<float> curve(numChannels, 20 * options.blockSize + 377);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < curve.getNumSamples(); ++i)
+            curve.getWritePointer(channel)[i] = noise(random);
+
+    TemporaryFile temp(".grenv");
+    writeEnvelope(temp.getFile(), curve, options);
+
+    GainEnvelopeReader reader(temp.getFile());
+    expect(reader.openedOk(), "reader opens the file");
+
+    auto length = static_cast<int>(reader.getLengthInSamples());
+    AudioBuffer<float> sequential(numChannels, length);
+    reader.read(sequential, 0, 0, length);
+
+    auto error = worstError(curve, sequential, length);
+    expect(error <= options.maxErrorDb, "sequential read within the error bound (worst " + String(error) + " dB)");
+
+    std::uniform_int_distribution<int> start(-2000, length + 2000);
+    std::uniform_int_distribution<int> size(1, 5000);
+    AudioBuffer<float> range(numChannels, 5000);
+    auto mismatches = 0;
+
+    for (int trial = 0; trial < 500; ++trial)
+    {
+        auto first = start(random);
+        auto numSamples = size(random);
+
+        if (! reader.read(range, 0, first, numSamples))
+        {
+            ++mismatches;
+            continue;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto position = first + i;
+                auto expected = position >= 0 && position < length ? sequential.getReadPointer(channel)[position] : 0.0f;
+
+                if (! exactlyEqual(range.getReadPointer(channel)[i], expected))
+                {
+                    ++mismatches;
+                    channel = numChannels;
+                    break;
+                }
+            }
+        }
+    }
+
+    expect(mismatches == 0, "500 random ranges match the sequential read (" + String(mismatches) + " mismatches)");
+}
+
+//==============================================================================
+/** Whether the reader still opens a valid file with one int64 rewritten */
+static bool opensWithInt64At(const File& source, int64 byteOffset, int64 value)
+{
+    MemoryBlock data;
+    source.loadFileAsData(data);
+
+    auto littleEndian = ByteOrder::swapIfBigEndian(value);
+    data.copyFrom(&littleEndian, (size_t) byteOffset, sizeof(littleEndian));
+
+    TemporaryFile corrupt(".grenv");
+    corrupt.getFile().replaceWithData(data.getData(), data.getSize());
+
+    GainEnvelopeReader reader(corrupt.getFile());
+    return reader.openedOk();
+}
+
+static void testCorruptIndexRejected()
+{
+    std::cout << "Corrupt block index" << std::endl;
+
+    GainEnvelopeWriter::Options options;
+    options.blockSize = 512;
+
+    AudioBuffer<float> curve(numChannels, 6 * options.blockSize);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < curve.getNumSamples(); ++i)
+            curve.getWritePointer(channel)[i] = static_cast<float>((i * 7919 + channel * 31) % 1200) * 0.01f;
+
+    TemporaryFile temp(".grenv");
+    writeEnvelope(temp.getFile(), curve, options);
+    auto file = temp.getFile();
+
+    MemoryBlock data;
+    file.loadFileAsData(data);
+
+    auto totalLength = static_cast<int64>(data.getSize());
+    auto indexOffset = ByteOrder::littleEndianInt64(static_cast<const char*>(data.getData()) + totalLength - 24);
+    auto offsetOf = [&] (int block) { return ByteOrder::littleEndianInt64(static_cast<const char*>(data.getData()) + indexOffset + 8 * block); };
+    auto entry = [&] (int block) { return indexOffset + 8 * block; };
+
+    expect(GainEnvelopeReader(file).openedOk(), "intact file opens");
+    expect(! opensWithInt64At(file, entry(2), offsetOf(4)), "offsets out of order are rejected");
+    expect(! opensWithInt64At(file, entry(3), offsetOf(2)), "repeated offset is rejected");
+    expect(! opensWithInt64At(file, entry(5), indexOffset), "block starting at the index is rejected");
+    expect(! opensWithInt64At(file, entry(5), totalLength + 4096), "offset past the end of the file is rejected");
+    expect(! opensWithInt64At(file, entry(0), 0), "offset inside the header is rejected");
+    expect(! opensWithInt64At(file, entry(1), -100), "negative offset is rejected");
+    expect(! opensWithInt64At(file, totalLength - 16, 7 * options.blockSize), "length beyond the block count is rejected");
+
+    TemporaryFile truncated(".grenv");
+    truncated.getFile().replaceWithData(data.getData(), data.getSize() - 8);
+    expect(! GainEnvelopeReader(truncated.getFile()).openedOk(), "truncated file is rejected");
+}
+
+//==============================================================================
+int main()
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::cout << "=== GAIN ENVELOPE SIDECAR TEST ===" << std::endl;
+
+    testExactDecimation();
+    testRandomSeek();
+    testCorruptIndexRejected();
+
+    std::cout << std::endl;
+    std::cout << (numFailures == 0 ? "PASS" : "FAIL: " + std::to_string(numFailures) + " check(s) failed") << std::endl;
+
+    return numFailures == 0 ? 0 : 1;
+}